@@ -0,0 +1,299 @@
+#include "acquisition.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "precise_sleep.h"
+
+using Clock = std::chrono::steady_clock;
+
+void Acquisition::Start(TicDevice& device, double rateHz, Clock::time_point epoch)
+{
+	if (bRunning.load()) {
+		return;
+	}
+
+	Device = &device;
+	Epoch = (epoch == Clock::time_point{}) ? device.Now() : epoch;
+
+	RateHz.store(rateHz);
+	bRunning.store(true);
+
+	Worker = std::thread(&Acquisition::Run, this);
+}
+
+double Acquisition::GetTime() const
+{
+	return Device ? std::chrono::duration<double>(Device->Now() - Epoch).count() : 0.0;
+}
+
+void Acquisition::Stop()
+{
+	bRunning.store(false);
+
+	if (Worker.joinable()) {
+		Worker.join();
+	}
+
+	std::lock_guard<std::mutex> lock(PostMutex);
+	Posted.clear();
+}
+
+std::string Acquisition::GetLastError()
+{
+	std::lock_guard<std::mutex> lock(ErrorMutex);
+	return LastError;
+}
+
+void Acquisition::Report(const std::exception& error)
+{
+	std::lock_guard<std::mutex> lock(ErrorMutex);
+
+	if (LastError != error.what()) {
+		LastError = error.what();
+		std::cerr << "Error: " << LastError << std::endl;
+	}
+}
+
+void Acquisition::Wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(WakeMutex);
+		bWoken = true;
+	}
+
+	WakeUp.notify_one();
+}
+
+void Acquisition::RunPosted()
+{
+	std::deque<std::function<void(TicDevice&)>> posted;
+
+	{
+		std::lock_guard<std::mutex> lock(PostMutex);
+		posted.swap(Posted);
+	}
+
+	// one failing doesn't stop the rest, or the poll
+	for (auto& fn : posted) {
+		try {
+			fn(*Device);
+		}
+		catch (const std::exception& error) {
+			Report(error);
+		}
+	}
+}
+
+void Acquisition::SetTable(std::shared_ptr<const SetpointTable> table)
+{
+	std::lock_guard<std::mutex> lock(TableMutex);
+
+	Table = std::move(table);
+	TableStart = Device ? Device->Now() : Clock::now();
+
+	Wake();
+}
+
+bool Acquisition::HasTable()
+{
+	std::lock_guard<std::mutex> lock(TableMutex);
+	return Table != nullptr;
+}
+
+void Acquisition::DriveVelocity(const TicSample& sample, int32_t target, int32_t velocity)
+{
+	// device time, the table's lookahead assumes the velocity is held for VelocityInterval of it
+	const Clock::time_point now = Device->Now();
+
+	if (bVelocitySent && now < NextVelocity) {
+		return;
+	}
+
+	NextVelocity = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(VelocityInterval));
+
+	// a proportional nudge towards the table's position, so rounding and the TIC's
+	// own acceleration limits don't let it drift
+	const double limit = sample.MaxSpeed ? (double)sample.MaxSpeed : (double)INT32_MAX;
+
+	double command = velocity + (double)(target - sample.CurrentPosition) * CorrectionGain * 10000.0;
+
+	if (command > limit) {
+		command = limit;
+	}
+
+	if (command < -limit) {
+		command = -limit;
+	}
+
+	const int32_t next = (int32_t)command;
+
+	if (!bVelocitySent || abs(next - SentVelocity) > VelocityDeadband) {
+		Device->set_target_velocity(next);
+		SentVelocity = next;
+		bVelocitySent = true;
+		Commands++;
+	}
+}
+
+void Acquisition::NotifyIfChanged(const TicSample& sample, Clock::time_point now)
+{
+	void (*notify)() = Notify.load();
+
+	if (!notify) {
+		return;
+	}
+
+	// VIN wanders every sample, it isn't a reason to draw
+	bNotifyPending |= sample.CurrentPosition != Previous.CurrentPosition || sample.CurrentVelocity != Previous.CurrentVelocity ||
+		sample.RequestPosition != Previous.RequestPosition || sample.OperationState != Previous.OperationState || sample.ErrorStatus != Previous.ErrorStatus;
+
+	Previous = sample;
+
+	if (bNotifyPending && now - LastNotify >= std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / NotifyRateHz))) {
+		notify();
+		bNotifyPending = false;
+		LastNotify = now;
+	}
+}
+
+void Acquisition::Poll(TicSample& sample)
+{
+	bool bTable = false;
+	bool bVelocity = false;
+	int32_t velocity = 0;
+
+	// step the running profile, if any
+	{
+		std::lock_guard<std::mutex> lock(TableMutex);
+
+		if (Table) {
+			bTable = true;
+
+			const double t = std::chrono::duration<double>(Device->Now() - TableStart).count();
+
+			Target.store(Table->At(t));
+
+			if (Table->bVelocity) {
+				bVelocity = true;
+				// the velocity halfway through the interval it'll be held for
+				velocity = Table->VelocityAt(t + VelocityInterval / 2.0);
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(DeviceMutex);
+
+	// anything posted goes first so this poll's sample already shows it
+	RunPosted();
+
+	const int32_t target = Target.load();
+
+	Device->get_variables(sample);
+
+	// stamped under the device lock, so a command posted or sent under it falls cleanly
+	// before or after this sample
+	sample.Time = GetTime();
+
+	// behind a TicCommandQueue this only goes when the TIC is in safe start
+	Device->exit_safe_start();
+
+	if (bVelocity) {
+		DriveVelocity(sample, target, velocity);
+	}
+	else if (sample.CurrentPosition != target || bVelocitySent) {
+
+		// a position command also takes the TIC out of velocity mode
+		Device->set_target_position(target);
+		bVelocitySent = false;
+		Commands++;
+	}
+
+	sample.RequestPosition = target;
+
+	// still, and either there or unable to get there until something changes
+	const bool bStill = sample.CurrentVelocity == 0 && (sample.CurrentPosition == target || sample.OperationState != TIC_OPERATION_STATE_NORMAL);
+
+	// a recording or a sink (trainer, tuner) wants every sample at the rate asked for
+	const Recorder* recorder = Record.load();
+	const bool bWatched = (recorder && recorder->IsOpen()) || Sink.load() != nullptr;
+
+	bIdle.store(bIdlePoll.load() && !bWatched && !bTable && bStill);
+}
+
+void Acquisition::Run()
+{
+	const Clock::time_point start = Clock::now();
+
+	Clock::time_point next = start;
+	Clock::time_point rateWindow = start;
+	uint64_t rateCount = 0;
+
+	while (bRunning.load()) {
+
+		TicSample sample = {};
+
+		try {
+			Poll(sample);
+
+			if (!Samples.Push(sample)) {
+				Dropped++;
+			}
+
+			if (Recorder* recorder = Record.load()) {
+				recorder->Write(sample);
+			}
+
+			if (SampleSink* sink = Sink.load()) {
+				sink->OnSample(sample);
+			}
+
+			NotifyIfChanged(sample, Clock::now());
+
+			rateCount++;
+		}
+		catch (const std::exception& error) {
+			Report(error);
+		}
+
+		const Clock::time_point now = Clock::now();
+
+		if (now - rateWindow >= std::chrono::seconds(1)) {
+			const double window = std::chrono::duration<double>(now - rateWindow).count();
+
+			MeasuredRate.store(rateCount / window);
+			CommandRate.store(Commands / window);
+
+			rateWindow = now;
+			rateCount = 0;
+			Commands = 0;
+		}
+
+		const double rate = bIdle.load() ? std::min(RateHz.load(), IdleRateHz) : RateHz.load();
+		const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / (rate > 0 ? rate : 1.0)));
+
+		next += period;
+
+		// fell behind (slow USB transfer), don't try to catch up with a burst
+		if (next < now) {
+			next = now;
+		}
+
+		if (bIdle.load()) {
+
+			// anything to do ends the wait early, a coarse wakeup doesn't matter here
+			std::unique_lock<std::mutex> lock(WakeMutex);
+
+			if (WakeUp.wait_until(lock, next, [this] { return bWoken; })) {
+				next = Clock::now();
+			}
+
+			bWoken = false;
+		}
+		else {
+			// spin no more than a small part of the period, so a 1kHz poll isn't a busy loop
+			SleepUntil(next, std::min<Clock::duration>(period / 20, DefaultSpin));
+		}
+	}
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+// fixed rate polling of a TIC on its own thread, so USB round-trips never stall
+// the GUI and the sample rate is no longer tied to vSync
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "profile.h"
+#include "recorder.h"
+#include "spsc_ring.h"
+#include "tic_device.h"
+
+// handed every sample on the acquisition thread, must be quick and never block
+class SampleSink {
+
+public:
+
+	virtual ~SampleSink() {}
+
+	virtual void OnSample(const TicSample& sample) = 0;
+};
+
+class Acquisition {
+
+public:
+
+	static constexpr size_t RingSize = 8192;
+
+	// velocity tables: how often a new velocity is worked out, how hard (per second) the
+	// position error is corrected and how far the velocity must move before it's sent.
+	// the TIC carries on at the last velocity, so this is far fewer commands than chasing positions
+	static constexpr double VelocityInterval = 0.02;
+	static constexpr double CorrectionGain = 5.0;
+	static constexpr int32_t VelocityDeadband = 5000;
+
+	// poll rate while the TIC is still with nothing to chase, if SetIdlePoll(true). never
+	// while a recording is open or a sink is attached, they get every sample at RateHz.
+	// SetTarget(), SetTable() and Post() wake the thread straight away
+	static constexpr double IdleRateHz = 50.0;
+
+	Acquisition() {}
+	~Acquisition() { Stop(); }
+
+	Acquisition(const Acquisition&) = delete;
+	Acquisition& operator=(const Acquisition&) = delete;
+
+	// start polling device at rateHz, samples are timestamped in seconds from epoch on the
+	// device's clock, a default epoch is the device's now. TICs started with the same epoch
+	// share a time base
+	void Start(TicDevice& device, double rateHz = 1000.0, std::chrono::steady_clock::time_point epoch = {});
+	void Stop();
+
+	bool IsRunning() const { return bRunning.load(); }
+
+	// seconds since the epoch on the device's clock, the time base of the samples
+	double GetTime() const;
+
+	// change the poll rate while running
+	void SetRate(double rateHz) { RateHz.store(rateHz); }
+	double GetRate() const { return RateHz.load(); }
+
+	// drop to IdleRateHz while nothing is happening, off by default so the poll rate is the rate
+	void SetIdlePoll(bool bEnable)
+	{
+		bIdlePoll.store(bEnable);
+		Wake();
+	}
+	bool GetIdlePoll() const { return bIdlePoll.load(); }
+
+	// position the acquisition thread keeps the TIC moving towards
+	void SetTarget(int32_t target)
+	{
+		if (Target.exchange(target) != target) {
+			Wake();
+		}
+	}
+	int32_t GetTarget() const { return Target.load(); }
+
+	// step through table from now on, each poll takes the target from it. nullptr goes back to SetTarget()
+	void SetTable(std::shared_ptr<const SetpointTable> table);
+	bool HasTable();
+
+	// take this before talking to the device from any other thread
+	std::unique_lock<std::mutex> LockDevice() { return std::unique_lock<std::mutex>(DeviceMutex); }
+
+	// run fn(device) on the acquisition thread at the start of its next poll, in the same
+	// lock as that poll's read and target, and return straight away. the future has fn's
+	// result, or its exception, which also goes to GetLastError(). posts run in order, and
+	// any still queued when the thread stops are dropped (broken promise)
+	template <typename Fn>
+	auto Post(Fn fn) -> std::future<decltype(fn(std::declval<TicDevice&>()))>;
+
+	// the same, with done called on the acquisition thread once fn has run, whether it threw
+	// or not. done(error) for a void fn, otherwise done(error, result) with a default
+	// constructed result if it threw. error is null on success. must be quick
+	template <typename Fn, typename Done>
+	void Post(Fn fn, Done done);
+
+	// every sample polled is also handed to recorder, nullptr to stop. the recorder must outlive the thread
+	void SetRecorder(Recorder* recorder) { Record.store(recorder); }
+
+	// same for a sink, for consumers that can't wait for the GUI to drain the ring
+	// called on the acquisition thread when a sample shows the TIC doing something new
+	// (moving, a new target, state or error), at most NotifyRateHz. wakes a sleeping render loop
+	static constexpr double NotifyRateHz = 60.0;
+
+	void SetNotify(void (*notify)()) { Notify.store(notify); }
+
+	void SetSink(SampleSink* sink)
+	{
+		Sink.store(sink);
+		Wake();
+	}
+
+	// consumer side, GUI thread only
+	bool PopSample(TicSample& sample) { return Samples.Pop(sample); }
+
+	// true while polling at IdleRateHz
+	bool IsIdle() const { return bIdle.load(); }
+
+	// measured poll rate over the last second
+	double GetMeasuredRate() const { return MeasuredRate.load(); }
+
+	// set_target_position and set_target_velocity sent per second over the last second
+	double GetCommandRate() const { return CommandRate.load(); }
+
+	// samples dropped because the GUI wasn't draining the ring
+	uint64_t GetDropped() const { return Dropped.load(); }
+
+	// last error from the device, empty if none
+	std::string GetLastError();
+
+private:
+
+	void Run();
+	void Poll(TicSample& sample);
+
+	// everything posted so far, under the device lock
+	void RunPosted();
+
+	// an error for GetLastError(), printed once per new message
+	void Report(const std::exception& error);
+
+	// cut an idle wait short
+	void Wake();
+
+	// set_target_velocity for the table's velocity at t, plus a correction towards target
+	void DriveVelocity(const TicSample& sample, int32_t target, int32_t velocity);
+
+	// Notify for a sample that changes what's shown, rate limited
+	void NotifyIfChanged(const TicSample& sample, std::chrono::steady_clock::time_point now);
+
+	TicDevice* Device = nullptr;
+
+	std::thread Worker;
+	std::mutex DeviceMutex;
+	std::mutex ErrorMutex;
+	std::mutex TableMutex;
+	std::mutex PostMutex;
+	std::mutex WakeMutex;
+	std::condition_variable WakeUp;
+	bool bWoken = false;
+
+	std::atomic<bool> bRunning{ false };
+	std::atomic<double> RateHz{ 1000.0 };
+	std::atomic<int32_t> Target{ 0 };
+
+	std::atomic<bool> bIdlePoll{ false };
+	std::atomic<bool> bIdle{ false };
+	std::atomic<double> MeasuredRate{ 0 };
+	std::atomic<double> CommandRate{ 0 };
+	std::atomic<uint64_t> Dropped{ 0 };
+
+	std::atomic<Recorder*> Record{ nullptr };
+	std::atomic<SampleSink*> Sink{ nullptr };
+	std::atomic<void (*)()> Notify{ nullptr };
+
+	std::string LastError;
+
+	std::deque<std::function<void(TicDevice&)>> Posted;
+
+	std::chrono::steady_clock::time_point Epoch;
+
+	std::shared_ptr<const SetpointTable> Table;
+	std::chrono::steady_clock::time_point TableStart;
+
+	// acquisition thread only
+	uint64_t Commands = 0;
+	bool bVelocitySent = false;
+	int32_t SentVelocity = 0;
+	std::chrono::steady_clock::time_point NextVelocity;
+
+	// the last sample polled, and a change in it not yet passed on to Notify
+	TicSample Previous = {};
+	bool bNotifyPending = false;
+	std::chrono::steady_clock::time_point LastNotify;
+
+	SpscRing<TicSample, RingSize> Samples;
+};
+
+template <typename Fn>
+auto Acquisition::Post(Fn fn) -> std::future<decltype(fn(std::declval<TicDevice&>()))>
+{
+	using Result = decltype(fn(std::declval<TicDevice&>()));
+
+	// std::function needs copyable, the promise isn't
+	auto promise = std::make_shared<std::promise<Result>>();
+	std::future<Result> result = promise->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(PostMutex);
+
+		Posted.push_back([promise, fn = std::move(fn)](TicDevice& device) mutable {
+			try {
+				if constexpr (std::is_void<Result>::value) {
+					fn(device);
+					promise->set_value();
+				}
+				else {
+					promise->set_value(fn(device));
+				}
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+				throw;
+			}
+		});
+	}
+
+	Wake();
+
+	return result;
+}
+
+template <typename Fn, typename Done>
+void Acquisition::Post(Fn fn, Done done)
+{
+	{
+		std::lock_guard<std::mutex> lock(PostMutex);
+
+		Posted.push_back([fn = std::move(fn), done = std::move(done)](TicDevice& device) mutable {
+			using Result = decltype(fn(device));
+
+			std::exception_ptr error;
+
+			if constexpr (std::is_void<Result>::value) {
+				try {
+					fn(device);
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+
+				done(error);
+			}
+			else {
+				Result result{};
+
+				try {
+					result = fn(device);
+				}
+				catch (...) {
+					error = std::current_exception();
+				}
+
+				done(error, std::move(result));
+			}
+
+			// still reported, the same as a future's
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		});
+	}
+
+	Wake();
+}
@@ -6,6 +6,7 @@
 #include "imgui/imgui_impl_dx12.h"
 
 #include "imgui/implot.h"
+#include "render_scheduler.h"
 
 #include <d3d12.h>
 #include <dxgi1_4.h>
@@ -25,6 +26,7 @@
 int RenderGUI();
 
 extern bool bBorderless, bVSync;
+extern RenderScheduler renderScheduler;
 static HWND hwnd;
 
 ///  dx and imgui code
@@ -520,6 +522,14 @@ void RenderLoop(void)
 		if (::PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
 			::TranslateMessage(&msg);
 			::DispatchMessage(&msg);
+			renderScheduler.Wake();
+			continue;
+		}
+
+		// nothing queued, sleep until input or the next idle redraw. straight through while data is live
+		const double wait = renderScheduler.WaitTime();
+
+		if (wait > 0 && ::MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(wait * 1000.0), QS_ALLINPUT) == WAIT_OBJECT_0) {
 			continue;
 		}
 
@@ -572,6 +582,16 @@ void RenderLoop(void)
 		g_pd3dCommandQueue->Signal(g_fence, fenceValue);
 		g_fenceLastSignaledValue = fenceValue;
 		frameCtx->FenceValue = fenceValue;
+
+		renderScheduler.FrameDone();
+	}
+}
+
+// from any thread, MsgWaitForMultipleObjects() sees the message and the loop draws
+void WakeRenderLoop()
+{
+	if (hwnd) {
+		::PostMessage(hwnd, WM_NULL, 0, 0);
 	}
 }
 
@@ -0,0 +1,105 @@
+#ifdef _USE_HEADLESS_
+
+// no window and no GPU, runs the same GUI code at a fixed frame rate so the
+// acquisition thread and telemetry run on boxes without a display
+
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+#include "imgui/imgui.h"
+#include "imgui/implot.h"
+#include "render_scheduler.h"
+
+int RenderGUI();
+
+extern double dRunFor;
+extern RenderScheduler renderScheduler;
+
+static volatile std::sig_atomic_t bQuit = 0;
+
+static void OnSignal(int)
+{
+	bQuit = 1;
+}
+
+bool SetupImgui(void)
+{
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImPlot::CreateContext();
+
+	ImGuiIO& io = ImGui::GetIO();
+
+	// nowhere to draw, but NewFrame still wants a size and a built font atlas
+	io.DisplaySize = ImVec2(1280, 720);
+	io.IniFilename = NULL;
+
+	unsigned char* pixels;
+	int width, height;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	std::signal(SIGINT, OnSignal);
+	std::signal(SIGTERM, OnSignal);
+
+	return true;
+}
+
+void RenderLoop(void)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::time_point start = Clock::now();
+	const auto frame = std::chrono::microseconds(16667);
+
+	Clock::time_point next = start;
+	Clock::time_point last = start;
+
+	while (!bQuit) {
+
+		// frames come further apart while idle, time moves on by however long it was
+		const Clock::time_point now = Clock::now();
+		const double delta = std::chrono::duration<double>(now - last).count();
+
+		ImGui::GetIO().DeltaTime = (float)(delta > 1e-4 ? delta : 1e-4);
+		last = now;
+
+		ImGui::NewFrame();
+
+		RenderGUI();
+
+		ImGui::Render();
+
+		if (dRunFor > 0 && std::chrono::duration<double>(Clock::now() - start).count() >= dRunFor) {
+			break;
+		}
+
+		renderScheduler.FrameDone();
+
+		// 60Hz while live, the idle rate otherwise
+		const double wait = renderScheduler.WaitTime();
+
+		next += frame;
+
+		if (wait > 0) {
+			next = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(wait));
+		}
+
+		std::this_thread::sleep_until(next);
+	}
+}
+
+// nothing is shown, the loop keeps its own time
+void WakeRenderLoop(void)
+{
+}
+
+bool CleanupImgui(void)
+{
+	ImPlot::DestroyContext();
+	ImGui::DestroyContext();
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+// min/max level-of-detail pyramid over a sample stream, built as samples arrive.
+// level L summarises Fanout^L samples per bucket, keeping where the min and max
+// sat so a plot can draw them in time order and spikes survive decimation
+
+#include <cstdint>
+#include <vector>
+
+class MinMaxPyramid {
+
+public:
+
+	static constexpr int FanoutBits = 3;
+	static constexpr uint64_t Fanout = 1ull << FanoutBits;
+
+	struct Bucket {
+		float Min, Max;
+
+		// offset of the min/max sample from the start of the bucket
+		uint32_t MinAt, MaxAt;
+	};
+
+	// capacity is the number of raw samples the owner keeps
+	void Resize(uint64_t capacity)
+	{
+		Levels.clear();
+		Limits.clear();
+
+		for (uint64_t size = Fanout; size <= capacity; size <<= FanoutBits) {
+			Levels.emplace_back();
+			Limits.push_back((size_t)(capacity / size + 2));
+		}
+	}
+
+	void Clear()
+	{
+		for (auto& level : Levels) {
+			level.clear();
+		}
+	}
+
+	// index is the absolute sample number, must increase by one each call
+	void Push(uint64_t index, float value)
+	{
+		for (int l = 0; l < (int)Levels.size(); l++) {
+
+			const int shift = (l + 1) * FanoutBits;
+			const uint64_t id = index >> shift;
+			const uint32_t at = (uint32_t)(index - (id << shift));
+
+			Bucket& bucket = Slot(l, id, at == 0);
+
+			if (at == 0) {
+				bucket = { value, value, 0, 0 };
+				continue;
+			}
+
+			if (value < bucket.Min) {
+				bucket.Min = value;
+				bucket.MinAt = at;
+			}
+
+			if (value > bucket.Max) {
+				bucket.Max = value;
+				bucket.MaxAt = at;
+			}
+		}
+	}
+
+	int LevelCount() const { return (int)Levels.size(); }
+
+	// samples per bucket at level (0 is raw)
+	static uint64_t BucketSize(int level) { return 1ull << (level * FanoutBits); }
+
+	// bucket id at level 1.. holding that id, caller keeps ids inside what is still held
+	const Bucket& Get(int level, uint64_t id) const
+	{
+		const auto& buckets = Levels[level - 1];
+		return buckets[(size_t)(id % Limits[level - 1])];
+	}
+
+	// lowest level that keeps count samples at or under budget points
+	int PickLevel(uint64_t count, uint64_t budget) const
+	{
+		int level = 0;
+
+		while (level < (int)Levels.size() && (count >> (level * FanoutBits)) > budget) {
+			level++;
+		}
+
+		return level;
+	}
+
+private:
+
+	Bucket& Slot(int level, uint64_t id, bool open)
+	{
+		auto& buckets = Levels[level];
+		const size_t limit = Limits[level];
+		const size_t slot = (size_t)(id % limit);
+
+		// grow while filling, after that buckets are reused in place
+		if (open && buckets.size() < limit && slot == buckets.size()) {
+			buckets.push_back({});
+		}
+
+		return buckets[slot];
+	}
+
+	std::vector<std::vector<Bucket>> Levels;
+	std::vector<size_t> Limits;
+};
@@ -1,4 +1,4 @@
-#ifndef _USE_OPENGL_
+#if !defined(_USE_OPENGL_) && !defined(_USE_HEADLESS_)
 
 
 #include "imgui/imgui.h"
@@ -7,10 +7,17 @@
 #include <stdio.h>
 
 #include "imgui/implot.h"
+#include "render_scheduler.h"
+
 int RenderGUI();
 
+extern RenderScheduler renderScheduler;
+
 
+#ifdef _MSC_VER
 #pragma comment(lib,"opengl32.lib")
+#endif
+
 
 #if defined(IMGUI_IMPL_OPENGL_ES2)
 #include <GLES2/gl2.h>
@@ -117,7 +124,22 @@ void  RenderLoop(void)
         // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-        glfwPollEvents();
+        // Sleep until input or the next idle redraw, straight through while data is live.
+        const double wait = renderScheduler.WaitTime();
+
+        if (wait > 0) {
+            const double before = glfwGetTime();
+
+            glfwWaitEventsTimeout(wait);
+
+            // back early, something happened
+            if (glfwGetTime() - before < wait) {
+                renderScheduler.Wake();
+            }
+        }
+        else {
+            glfwPollEvents();
+        }
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -137,11 +159,19 @@ void  RenderLoop(void)
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+
+        renderScheduler.FrameDone();
     }
 
     return ;
 }
 
+// from any thread, glfwWaitEventsTimeout() returns early
+void WakeRenderLoop(void)
+{
+    glfwPostEmptyEvent();
+}
+
 bool CleanupImgui(void)
 {
     // Cleanup
@@ -0,0 +1,51 @@
+#include "precise_sleep.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static void SleepFor(Clock::duration duration)
+{
+#ifdef _WIN32
+	// one timer per calling thread. high resolution needs windows 10 1803, older falls back
+	// to a plain timer, no worse than sleep_until
+	static thread_local HANDLE timer = []() {
+		HANDLE handle = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		return handle ? handle : CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+	}();
+
+	LARGE_INTEGER due;
+
+	// 100ns units, negative is relative
+	due.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100);
+
+	if (timer && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+		WaitForSingleObject(timer, INFINITE);
+		return;
+	}
+#endif
+
+	std::this_thread::sleep_for(duration);
+}
+
+void SleepUntil(Clock::time_point deadline, Clock::duration spin)
+{
+	const Clock::time_point coarse = deadline - spin;
+	const Clock::time_point now = Clock::now();
+
+	if (now < coarse) {
+		SleepFor(coarse - now);
+	}
+
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// deadline sleeps for the threads that talk to TICs on a fixed timebase
+
+#include <chrono>
+
+// how much of a wait SleepUntil() yield-spins by default, well under a 1kHz poll period
+constexpr std::chrono::microseconds DefaultSpin{ 100 };
+
+// sleep until deadline, yield-spinning only the last spin of it. the sleep is a high
+// resolution waitable timer on windows, where sleep_until is only good to the scheduler
+// tick (up to ~15ms), and clock_nanosleep elsewhere, both good to well under spin
+void SleepUntil(std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::duration spin = DefaultSpin);
@@ -0,0 +1,283 @@
+#include "profile.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#ifndef M_PI
+#   define M_PI    3.14159265358979323846
+#endif
+
+double Profile::Velocity(double t) const
+{
+	const double h = 0.001;
+
+	return (Evaluate(t + h) - Evaluate(t - h)) / (2.0 * h);
+}
+
+MoveProfile::MoveProfile(std::vector<double> points, double maxVelocity, double maxAcceleration, double dwell, bool bSmooth) : Dwell(dwell), bSmooth(bSmooth)
+{
+	// a sinusoidal ramp peaks at pi/2 times the trapezoid's acceleration, so it takes that much longer
+	const double stretch = bSmooth ? M_PI / 2.0 : 1.0;
+
+	for (size_t i = 0; i < points.size(); i++) {
+
+		Segment segment;
+
+		segment.Start = Total;
+		segment.From = points[i];
+		segment.Distance = points[(i + 1) % points.size()] - points[i];
+
+		const double distance = fabs(segment.Distance);
+
+		segment.Velocity = maxVelocity;
+		segment.Ramp = stretch * maxVelocity / maxAcceleration;
+
+		// too short to reach full speed, ramp up and straight back down
+		if (segment.Velocity * segment.Ramp > distance) {
+			segment.Velocity = sqrt(distance * maxAcceleration / stretch);
+			segment.Ramp = stretch * segment.Velocity / maxAcceleration;
+		}
+
+		segment.Cruise = (segment.Velocity > 0) ? (distance - segment.Velocity * segment.Ramp) / segment.Velocity : 0;
+
+		Segments.push_back(segment);
+
+		Total += 2.0 * segment.Ramp + segment.Cruise + Dwell;
+	}
+}
+
+double MoveProfile::RampDistance(const Segment& segment, double t) const
+{
+	if (segment.Ramp <= 0) {
+		return 0;
+	}
+
+	if (bSmooth) {
+		return segment.Velocity / 2.0 * (t - segment.Ramp / M_PI * sin(M_PI * t / segment.Ramp));
+	}
+
+	return segment.Velocity * t * t / (2.0 * segment.Ramp);
+}
+
+double MoveProfile::RampSpeed(const Segment& segment, double t) const
+{
+	if (segment.Ramp <= 0) {
+		return 0;
+	}
+
+	if (bSmooth) {
+		return segment.Velocity / 2.0 * (1.0 - cos(M_PI * t / segment.Ramp));
+	}
+
+	return segment.Velocity * t / segment.Ramp;
+}
+
+const MoveProfile::Segment& MoveProfile::Find(double& t) const
+{
+	t = fmod(t, Total);
+
+	size_t i = 0;
+
+	while (i + 1 < Segments.size() && Segments[i + 1].Start <= t) {
+		i++;
+	}
+
+	t -= Segments[i].Start;
+
+	return Segments[i];
+}
+
+double MoveProfile::Evaluate(double t) const
+{
+	if (Segments.empty() || Total <= 0) {
+		return 0;
+	}
+
+	const Segment& segment = Find(t);
+
+	const double move = 2.0 * segment.Ramp + segment.Cruise;
+	const double distance = fabs(segment.Distance);
+
+	double covered = distance;
+
+	if (t < segment.Ramp) {
+		covered = RampDistance(segment, t);
+	}
+	else if (t < segment.Ramp + segment.Cruise) {
+		covered = segment.Velocity * segment.Ramp / 2.0 + segment.Velocity * (t - segment.Ramp);
+	}
+	else if (t < move) {
+		covered = distance - RampDistance(segment, move - t);
+	}
+
+	return segment.From + (segment.Distance < 0 ? -covered : covered);
+}
+
+double MoveProfile::Velocity(double t) const
+{
+	if (Segments.empty() || Total <= 0) {
+		return 0;
+	}
+
+	const Segment& segment = Find(t);
+
+	const double move = 2.0 * segment.Ramp + segment.Cruise;
+
+	double speed = 0;
+
+	if (t < segment.Ramp) {
+		speed = RampSpeed(segment, t);
+	}
+	else if (t < segment.Ramp + segment.Cruise) {
+		speed = segment.Velocity;
+	}
+	else if (t < move) {
+		speed = RampSpeed(segment, move - t);
+	}
+
+	return segment.Distance < 0 ? -speed : speed;
+}
+
+bool SplineProfile::Span(double t, double p[4], double& u, double& length) const
+{
+	const size_t count = Waypoints.size();
+
+	if (count == 0 || Period <= 0) {
+		return false;
+	}
+
+	t = fmod(t, Period);
+
+	size_t i = 0;
+
+	while (i + 1 < count && Waypoints[i + 1].Time <= t) {
+		i++;
+	}
+
+	const double t0 = Waypoints[i].Time;
+	const double t1 = (i + 1 < count) ? Waypoints[i + 1].Time : Period;
+
+	length = t1 - t0;
+	u = (length > 0) ? (t - t0) / length : 0;
+
+	p[0] = Waypoints[(i + count - 1) % count].Position;
+	p[1] = Waypoints[i].Position;
+	p[2] = Waypoints[(i + 1) % count].Position;
+	p[3] = Waypoints[(i + 2) % count].Position;
+
+	return true;
+}
+
+double SplineProfile::Evaluate(double t) const
+{
+	double p[4], u, length;
+
+	if (!Span(t, p, u, length)) {
+		return 0;
+	}
+
+	const double p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3];
+
+	const double position = 0.5 * ((2.0 * p1) + (p2 - p0) * u + (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * u * u + (3.0 * p1 - p0 - 3.0 * p2 + p3) * u * u * u);
+
+	// the curve can overshoot the waypoints a little
+	return position < -1.0 ? -1.0 : (position > 1.0 ? 1.0 : position);
+}
+
+double SplineProfile::Velocity(double t) const
+{
+	double p[4], u, length;
+
+	if (!Span(t, p, u, length) || length <= 0) {
+		return 0;
+	}
+
+	// held at the limit where Evaluate() clamps
+	const double position = Evaluate(t);
+
+	if (position <= -1.0 || position >= 1.0) {
+		return 0;
+	}
+
+	const double p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3];
+
+	return 0.5 * ((p2 - p0) + 2.0 * (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * u + 3.0 * (3.0 * p1 - p0 - 3.0 * p2 + p3) * u * u) / length;
+}
+
+SetpointTable BuildTable(const Profile& profile, double rateHz, double from, double to)
+{
+	const double scale = (to - from) / 2.0;
+
+	SetpointTable table;
+
+	table.RateHz = rateHz;
+	table.bLoop = profile.Loops();
+
+	const size_t count = (size_t)ceil(profile.Duration() * rateHz);
+
+	table.Setpoints.resize(count ? count : 1);
+	table.Velocities.resize(table.Setpoints.size());
+
+	for (size_t i = 0; i < table.Setpoints.size(); i++) {
+
+		const double t = i / rateHz;
+
+		table.Setpoints[i] = (int32_t)(from + (profile.Evaluate(t) + 1.0) * scale);
+
+		// steps per second to microsteps per 10000s, which can pass int32 on the widest ranges
+		const double velocity = profile.Velocity(t) * scale * 10000.0;
+
+		table.Velocities[i] = (int32_t)(velocity > INT32_MAX ? INT32_MAX : (velocity < -INT32_MAX ? -INT32_MAX : velocity));
+	}
+
+	return table;
+}
+
+const std::vector<ProfileEntry>& ProfileLibrary()
+{
+	static const std::vector<ProfileEntry> library = {
+		{ "SIN", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<WaveProfile>([](double t) { return sin(t); }, 2.0 * M_PI, [](double t) { return cos(t); });
+		} },
+		{ "SIN 2x", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<WaveProfile>([](double t) { return sin(t * 2.0); }, M_PI, [](double t) { return 2.0 * cos(t * 2.0); });
+		} },
+		//sin(2 * pi * x) + cos(x / 2 * pi)
+		{ "SIN 3", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<WaveProfile>([](double t) { return (sin(2.0 * M_PI * t) + cos(t / 2.0 * M_PI)) / 2.0; }, 4.0,
+				[](double t) { return (2.0 * M_PI * cos(2.0 * M_PI * t) - M_PI / 2.0 * sin(t / 2.0 * M_PI)) / 2.0; });
+		} },
+		{ "PING PONG", []() -> std::unique_ptr<Profile> {
+			// steps have no useful derivative, velocity control just corrects towards them
+			return std::make_unique<WaveProfile>([](double t) { return t < 1.0 ? -1.0 : 1.0; }, 2.0, [](double) { return 0.0; });
+		} },
+		{ "TRAPEZOID", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<MoveProfile>(std::vector<double>{ -1.0, 1.0 }, 1.0, 2.0, 0.5, false);
+		} },
+		{ "S-CURVE", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<MoveProfile>(std::vector<double>{ -1.0, 1.0 }, 1.0, 2.0, 0.5, true);
+		} },
+		{ "STEPS", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<MoveProfile>(std::vector<double>{ -1.0, -0.5, 0.0, 0.5, 1.0, 0.5, 0.0, -0.5 }, 1.0, 4.0, 0.25, true);
+		} },
+		{ "SPLINE", []() -> std::unique_ptr<Profile> {
+			return std::make_unique<SplineProfile>(std::vector<SplineProfile::Waypoint>{ { 0.0, -1.0 }, { 1.0, 0.5 }, { 2.0, -0.25 }, { 3.0, 1.0 } }, 4.0);
+		} },
+	};
+
+	return library;
+}
+
+int FindProfile(const char* name)
+{
+	const std::vector<ProfileEntry>& library = ProfileLibrary();
+
+	for (size_t i = 0; i < library.size(); i++) {
+		if (strcmp(library[i].Name, name) == 0) {
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
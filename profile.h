@@ -0,0 +1,159 @@
+#pragma once
+
+// motion profiles, worked out into a table of setpoints at a fixed rate before they
+// run, so the acquisition thread can step through them without the GUI being involved.
+// a profile is a normalised position from -1 to 1 against time, the same as the old
+// slider modes, and is mapped onto a TIC's range when the table is built
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Profile {
+
+public:
+
+	virtual ~Profile() {}
+
+	// one pass through the profile in seconds
+	virtual double Duration() const = 0;
+
+	// repeat forever, or hold the last position once done
+	virtual bool Loops() const { return true; }
+
+	// position at t, 0 <= t < Duration()
+	virtual double Evaluate(double t) const = 0;
+
+	// rate of change of position at t per second, numerically unless a profile knows better
+	virtual double Velocity(double t) const;
+};
+
+// any periodic function of time, the original sine and ping pong shapes. derivative
+// is the wave's own derivative if it has one
+class WaveProfile : public Profile {
+
+public:
+
+	WaveProfile(std::function<double(double)> wave, double period, std::function<double(double)> derivative = nullptr) : Wave(std::move(wave)), Derivative(std::move(derivative)), Period(period) {}
+
+	double Duration() const override { return Period; }
+	double Evaluate(double t) const override { return Wave(t); }
+	double Velocity(double t) const override { return Derivative ? Derivative(t) : Profile::Velocity(t); }
+
+private:
+
+	std::function<double(double)> Wave;
+	std::function<double(double)> Derivative;
+	double Period;
+};
+
+// point to point moves through a list of positions and back to the first, with a
+// dwell at each. trapezoidal velocity, or S-curve with a sinusoidal velocity ramp
+// that keeps acceleration continuous for the same peak acceleration
+class MoveProfile : public Profile {
+
+public:
+
+	MoveProfile(std::vector<double> points, double maxVelocity, double maxAcceleration, double dwell, bool bSmooth);
+
+	double Duration() const override { return Total; }
+	double Evaluate(double t) const override;
+	double Velocity(double t) const override;
+
+private:
+
+	struct Segment {
+		double Start;
+		double From;
+		double Distance;
+		double Velocity;
+		double Ramp;
+		double Cruise;
+	};
+
+	// distance covered and speed t into a segment's ramp up
+	double RampDistance(const Segment& segment, double t) const;
+	double RampSpeed(const Segment& segment, double t) const;
+
+	// segment t falls in, t wrapped to Total
+	const Segment& Find(double& t) const;
+
+	std::vector<Segment> Segments;
+	double Dwell;
+	bool bSmooth;
+	double Total = 0;
+};
+
+// Catmull-Rom spline through timed waypoints, wrapping from the last back to the first
+class SplineProfile : public Profile {
+
+public:
+
+	struct Waypoint {
+		double Time;
+		double Position;
+	};
+
+	// waypoints in time order from 0, period is when the first comes round again
+	SplineProfile(std::vector<Waypoint> waypoints, double period) : Waypoints(std::move(waypoints)), Period(period) {}
+
+	double Duration() const override { return Period; }
+	double Evaluate(double t) const override;
+	double Velocity(double t) const override;
+
+private:
+
+	// the four control points around t and how far t is between the middle two
+	bool Span(double t, double p[4], double& u, double& length) const;
+
+	std::vector<Waypoint> Waypoints;
+	double Period;
+};
+
+// setpoints for one TIC, stepped by Acquisition at RateHz
+struct SetpointTable {
+
+	double RateHz = 1000.0;
+	bool bLoop = true;
+
+	// drive the TIC with set_target_velocity from Velocities, correcting towards Setpoints
+	bool bVelocity = false;
+
+	std::vector<int32_t> Setpoints;
+
+	// the profile's derivative in TIC units, microsteps per 10000s
+	std::vector<int32_t> Velocities;
+
+	// setpoint t seconds after the table started
+	int32_t At(double t) const { return Setpoints.empty() ? 0 : Setpoints[Index(t)]; }
+	int32_t VelocityAt(double t) const { return Velocities.empty() ? 0 : Velocities[Index(t)]; }
+
+	size_t Index(double t) const
+	{
+		size_t index = (t > 0) ? (size_t)(t * RateHz) : 0;
+
+		if (bLoop) {
+			index %= Setpoints.size();
+		}
+		else if (index >= Setpoints.size()) {
+			index = Setpoints.size() - 1;
+		}
+
+		return index;
+	}
+};
+
+// one pass of profile at rateHz, with -1 mapped to from and 1 to to in TIC steps
+SetpointTable BuildTable(const Profile& profile, double rateHz, double from, double to);
+
+// the profiles offered in the GUI, add new ones to the list in profile.cpp
+struct ProfileEntry {
+	const char* Name;
+	std::unique_ptr<Profile> (*Make)();
+};
+
+const std::vector<ProfileEntry>& ProfileLibrary();
+
+// index into ProfileLibrary(), -1 if name isn't there
+int FindProfile(const char* name);
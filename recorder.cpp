@@ -0,0 +1,215 @@
+#include "recorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+bool Recorder::Open(const std::string& path)
+{
+	Close();
+
+	File = std::fopen(path.c_str(), "wb");
+
+	if (!File) {
+		std::cerr << "Error: can't create " << path << std::endl;
+		return false;
+	}
+
+	RecordFileHeader header = {};
+
+	memcpy(header.Magic, RecordMagic, sizeof(header.Magic));
+	header.Version = RecordVersion;
+	header.HeaderSize = sizeof(RecordFileHeader);
+	header.StartedAt = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	if (std::fwrite(&header, sizeof(header), 1, File) != 1) {
+		std::cerr << "Error: can't write " << path << std::endl;
+		std::fclose(File);
+		File = nullptr;
+		return false;
+	}
+
+	for (Block& block : Blocks) {
+		block.Data.clear();
+		block.Data.reserve(BlockSize + sizeof(RecordHeader) + sizeof(RecordedSample));
+		block.Count = 0;
+		block.bFull.store(false);
+	}
+
+	Path = path;
+	Active = 0;
+
+	Written.store(0);
+	Bytes.store(sizeof(header));
+	Dropped.store(0);
+
+	bStopping.store(false);
+	bOpen.store(true);
+
+	Writer = std::thread(&Recorder::Run, this);
+
+	return true;
+}
+
+void Recorder::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(ProducerMutex);
+
+		if (!bOpen.load()) {
+			return;
+		}
+
+		bOpen.store(false);
+
+		if (!Blocks[Active].bFull.load(std::memory_order_acquire)) {
+			Handover();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(WakeMutex);
+		bStopping.store(true);
+	}
+
+	Wake.notify_one();
+
+	if (Writer.joinable()) {
+		Writer.join();
+	}
+
+	std::fclose(File);
+	File = nullptr;
+}
+
+void Recorder::Write(const TicSample& sample)
+{
+	std::unique_lock<std::mutex> lock(ProducerMutex, std::try_to_lock);
+
+	// closing, or not recording
+	if (!lock.owns_lock() || !bOpen.load()) {
+		return;
+	}
+
+	Block& block = Blocks[Active];
+
+	// the writer still has both blocks
+	if (block.bFull.load(std::memory_order_acquire)) {
+		Dropped++;
+		return;
+	}
+
+	RecordHeader header;
+
+	header.Size = sizeof(RecordedSample);
+	header.Type = RecordTypeSample;
+
+	RecordedSample record;
+
+	record.Time				= sample.Time;
+	record.RequestPosition	= sample.RequestPosition;
+	record.TargetPosition	= sample.TargetPosition;
+	record.CurrentPosition	= sample.CurrentPosition;
+	record.CurrentVelocity	= sample.CurrentVelocity;
+	record.VinVoltage		= sample.VinVoltage;
+	record.ErrorsOccurred	= sample.ErrorsOccurred;
+	record.ErrorStatus		= sample.ErrorStatus;
+	record.OperationState	= sample.OperationState;
+	record.StepMode			= sample.StepMode;
+
+	// capacity was reserved in Open(), these never allocate
+	const size_t at = block.Data.size();
+
+	block.Data.resize(at + sizeof(header) + sizeof(record));
+	memcpy(&block.Data[at], &header, sizeof(header));
+	memcpy(&block.Data[at + sizeof(header)], &record, sizeof(record));
+
+	if (block.Count == 0) {
+		block.FirstTime = sample.Time;
+	}
+
+	block.LastTime = sample.Time;
+	block.Count++;
+
+	if (block.Data.size() >= BlockSize || sample.Time - block.FirstTime >= FlushInterval) {
+		Handover();
+	}
+}
+
+// producer side, ProducerMutex held
+void Recorder::Handover()
+{
+	Block& block = Blocks[Active];
+
+	if (block.Count == 0) {
+		return;
+	}
+
+	block.bFull.store(true, std::memory_order_release);
+	Active ^= 1;
+
+	Wake.notify_one();
+}
+
+bool Recorder::WriteBlock(Block& block)
+{
+	RecordBlockHeader header;
+
+	header.Magic = RecordBlockMagic;
+	header.Bytes = (uint32_t)block.Data.size();
+	header.Count = block.Count;
+	header.FirstTime = block.FirstTime;
+	header.LastTime = block.LastTime;
+
+	if (std::fwrite(&header, sizeof(header), 1, File) != 1 ||
+		std::fwrite(block.Data.data(), block.Data.size(), 1, File) != 1) {
+		return false;
+	}
+
+	// into the OS now, so a crash loses at most a block
+	std::fflush(File);
+
+	Bytes += sizeof(header) + block.Data.size();
+	Written += block.Count;
+
+	return true;
+}
+
+void Recorder::Run()
+{
+	// blocks are handed over alternately, write them back in the same order
+	int next = 0;
+	bool bFailed = false;
+
+	while (true) {
+
+		Block& block = Blocks[next];
+
+		if (!block.bFull.load(std::memory_order_acquire)) {
+
+			if (bStopping.load()) {
+				break;
+			}
+
+			// the producer doesn't take WakeMutex, so don't rely on never missing a notify
+			std::unique_lock<std::mutex> lock(WakeMutex);
+			Wake.wait_for(lock, std::chrono::milliseconds(50));
+			continue;
+		}
+
+		if (!bFailed && !WriteBlock(block)) {
+			std::cerr << "Error: writing " << Path << " failed, recording stopped" << std::endl;
+			bFailed = true;
+		}
+
+		if (bFailed) {
+			Dropped += block.Count;
+		}
+
+		block.Data.clear();
+		block.Count = 0;
+		block.bFull.store(false, std::memory_order_release);
+
+		next ^= 1;
+	}
+}
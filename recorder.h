@@ -0,0 +1,146 @@
+#pragma once
+
+// streams every acquired sample to a binary log. the acquisition thread copies samples
+// into one of two blocks, a writer thread puts full blocks on disk, so a slow disk costs
+// dropped samples (counted) rather than a stalled poll loop or GUI
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tic_device.h"
+
+// on disk, little endian, no padding:
+//   RecordFileHeader
+//   RecordBlockHeader, then Bytes of records, repeated
+// each record is RecordHeader followed by Size bytes of payload, readers skip types they
+// don't know and read the leading part of a payload that has grown in a newer version
+
+#pragma pack(push, 1)
+
+struct RecordFileHeader {
+	char Magic[8];
+	uint32_t Version;
+	uint32_t HeaderSize;
+
+	// wall clock the recording started, seconds since the unix epoch
+	double StartedAt;
+};
+
+struct RecordBlockHeader {
+	uint32_t Magic;
+	uint32_t Bytes;
+	uint32_t Count;
+
+	// sample times of the first and last record in the block
+	double FirstTime;
+	double LastTime;
+};
+
+struct RecordHeader {
+	uint16_t Size;
+	uint16_t Type;
+};
+
+struct RecordedSample {
+	double Time;
+
+	int32_t RequestPosition;
+	int32_t TargetPosition;
+	int32_t CurrentPosition;
+	int32_t CurrentVelocity;
+
+	uint32_t VinVoltage;
+	uint32_t ErrorsOccurred;
+	uint16_t ErrorStatus;
+
+	uint8_t OperationState;
+	uint8_t StepMode;
+};
+
+#pragma pack(pop)
+
+static constexpr char RecordMagic[8] = { 'T', 'I', 'C', 'T', 'U', 'N', 'E', 0 };
+static constexpr uint32_t RecordBlockMagic = 0x4b4c4254;	// "TBLK"
+static constexpr uint32_t RecordVersion = 1;
+
+enum RecordType : uint16_t {
+	RecordTypeSample = 1,
+};
+
+class Recorder {
+
+public:
+
+	// bytes of records per block, about a second of samples at 1kHz
+	static constexpr size_t BlockSize = 64 * 1024;
+
+	Recorder() {}
+	~Recorder() { Close(); }
+
+	Recorder(const Recorder&) = delete;
+	Recorder& operator=(const Recorder&) = delete;
+
+	// start a new log, false if the file couldn't be created
+	bool Open(const std::string& path);
+
+	// hands over the partly filled block and waits for everything to reach the file
+	void Close();
+
+	bool IsOpen() const { return bOpen.load(); }
+
+	// producer side, never blocks. a partly filled block is handed over once it is
+	// FlushInterval seconds old so the file is never far behind
+	void Write(const TicSample& sample);
+
+	double FlushInterval = 0.25;
+
+	const std::string& GetPath() const { return Path; }
+
+	uint64_t GetWritten() const { return Written.load(); }
+	uint64_t GetBytes() const { return Bytes.load(); }
+
+	// samples lost because both blocks were full, or the file couldn't be written
+	uint64_t GetDropped() const { return Dropped.load(); }
+
+private:
+
+	struct Block {
+		std::vector<uint8_t> Data;
+		uint32_t Count = 0;
+		double FirstTime = 0;
+		double LastTime = 0;
+
+		// set by the producer when handing over, cleared by the writer once it's on disk
+		std::atomic<bool> bFull{ false };
+	};
+
+	void Run();
+	void Handover();
+	bool WriteBlock(Block& block);
+
+	std::FILE* File = nullptr;
+	std::string Path;
+
+	Block Blocks[2];
+	int Active = 0;
+
+	std::thread Writer;
+	std::mutex WakeMutex;
+	std::condition_variable Wake;
+
+	// producer takes this with try_lock, so Close() can't pull the blocks out from under Write()
+	std::mutex ProducerMutex;
+
+	std::atomic<bool> bOpen{ false };
+	std::atomic<bool> bStopping{ false };
+
+	std::atomic<uint64_t> Written{ 0 };
+	std::atomic<uint64_t> Bytes{ 0 };
+	std::atomic<uint64_t> Dropped{ 0 };
+};
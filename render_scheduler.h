@@ -0,0 +1,59 @@
+#pragma once
+
+// decides when the render loop draws. while data is live (a motor moving, a profile or
+// scheduler running) every frame is drawn at the display rate, otherwise the loop sleeps
+// until input arrives, an acquisition thread polls something new (WakeRenderLoop()) or the
+// idle redraw comes due, so a TIC sat on the bench costs nothing
+
+#include <chrono>
+
+class RenderScheduler {
+
+public:
+
+	// frames drawn after input, imgui needs a couple to settle hovers and clicks
+	static constexpr int SettleFrames = 3;
+
+	// redraws per second with nothing live, keeps the readouts ticking over
+	void SetIdleRate(double hz) { IdleRate = hz > 0 ? hz : 1.0; }
+	double GetIdleRate() const { return IdleRate; }
+
+	// set every frame by the GUI, true draws at the display rate
+	void SetLive(bool bLive) { bIsLive = bLive; }
+	bool IsLive() const { return bIsLive; }
+
+	// input arrived or something wants a prompt redraw
+	void Wake() { Settle = SettleFrames; }
+
+	// the render loop drew a frame
+	void FrameDone()
+	{
+		LastFrame = Clock::now();
+
+		if (Settle > 0) {
+			Settle--;
+		}
+	}
+
+	// seconds the render loop may wait for input before the next frame, 0 draws straight away
+	double WaitTime() const
+	{
+		if (bIsLive || Settle > 0) {
+			return 0;
+		}
+
+		const double wait = 1.0 / IdleRate - std::chrono::duration<double>(Clock::now() - LastFrame).count();
+
+		return wait > 0 ? wait : 0;
+	}
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	double IdleRate = 5.0;
+	bool bIsLive = true;
+	int Settle = SettleFrames;
+
+	Clock::time_point LastFrame = Clock::now();
+};
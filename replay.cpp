@@ -0,0 +1,348 @@
+#include "replay.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool Replay::Map(const std::string& path)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	FileHandle = file;
+	MappingHandle = mapping;
+
+	Data = (const uint8_t*)view;
+	Size = (uint64_t)size.QuadPart;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	Data = (const uint8_t*)view;
+	Size = (uint64_t)info.st_size;
+#endif
+
+	return true;
+}
+
+void Replay::Unmap()
+{
+	if (!Data) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(Data);
+	CloseHandle((HANDLE)MappingHandle);
+	CloseHandle((HANDLE)FileHandle);
+
+	FileHandle = nullptr;
+	MappingHandle = nullptr;
+#else
+	munmap((void*)Data, (size_t)Size);
+#endif
+
+	Data = nullptr;
+	Size = 0;
+}
+
+bool Replay::Open(const std::string& path)
+{
+	Close();
+
+	Error.clear();
+
+	if (!Map(path)) {
+		Error = "can't open " + path;
+		return false;
+	}
+
+	RecordFileHeader header;
+
+	if (Size < sizeof(header)) {
+		Error = path + " is too short to be a recording";
+		Unmap();
+		return false;
+	}
+
+	memcpy(&header, Data, sizeof(header));
+
+	if (memcmp(header.Magic, RecordMagic, sizeof(header.Magic)) != 0) {
+		Error = path + " is not a ticTune recording";
+		Unmap();
+		return false;
+	}
+
+	if (header.Version > RecordVersion) {
+		Error = path + " was written by a newer ticTune";
+		Unmap();
+		return false;
+	}
+
+	// only block headers are touched here, one page per block
+	uint64_t offset = header.HeaderSize;
+	uint64_t records = 0;
+
+	while (offset + sizeof(RecordBlockHeader) <= Size) {
+
+		RecordBlockHeader block;
+
+		memcpy(&block, Data + offset, sizeof(block));
+
+		// a recording cut off mid-block (crash, full disk) still replays up to here
+		if (block.Magic != RecordBlockMagic || offset + sizeof(block) + block.Bytes > Size) {
+			break;
+		}
+
+		Entry entry;
+
+		entry.Offset = offset + sizeof(block);
+		entry.Bytes = block.Bytes;
+		entry.Count = block.Count;
+		entry.FirstRecord = records;
+		entry.FirstTime = block.FirstTime;
+		entry.LastTime = block.LastTime;
+
+		Index.push_back(entry);
+
+		records += block.Count;
+		offset = entry.Offset + block.Bytes;
+	}
+
+	if (Index.empty()) {
+		Error = path + " has no samples";
+		Unmap();
+		return false;
+	}
+
+	Path = path;
+
+	return true;
+}
+
+void Replay::Close()
+{
+	Unmap();
+
+	Index.clear();
+	Path.clear();
+}
+
+size_t Replay::Seek(double t) const
+{
+	size_t lo = 0, hi = Index.size();
+
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+
+		if (Index[mid].LastTime < t) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+template <typename F>
+void Replay::ForEachSample(const Entry& block, F f) const
+{
+	const uint8_t* at = Data + block.Offset;
+	const uint8_t* end = at + block.Bytes;
+
+	while (at + sizeof(RecordHeader) <= end) {
+
+		RecordHeader header;
+
+		memcpy(&header, at, sizeof(header));
+		at += sizeof(header);
+
+		if (at + header.Size > end) {
+			break;
+		}
+
+		if (header.Type == RecordTypeSample) {
+
+			// older files may have written fewer fields, those stay zero
+			RecordedSample sample = {};
+
+			memcpy(&sample, at, header.Size < sizeof(sample) ? header.Size : sizeof(sample));
+			f(sample);
+		}
+
+		at += header.Size;
+	}
+}
+
+static TelemetryRow ToRow(const RecordedSample& sample)
+{
+	TelemetryRow row;
+
+	row.Time = sample.Time;
+	row.Target = sample.RequestPosition;
+	row.Position = sample.CurrentPosition;
+	row.Velocity = sample.CurrentVelocity / 10000.0f;
+	row.Vin = sample.VinVoltage / 1000.0f;
+
+	return row;
+}
+
+bool Replay::Load(TelemetryStore& store, double from, double to) const
+{
+	store.Erase();
+
+	if (Index.empty() || to < from) {
+		return false;
+	}
+
+	const size_t first = Seek(from);
+
+	if (first == Index.size()) {
+		return false;
+	}
+
+	// last block starting at or before to
+	size_t last = Seek(to);
+
+	if (last == Index.size() || Index[last].FirstTime > to) {
+		last = (last > first) ? last - 1 : first;
+	}
+
+	const size_t blocks = last - first + 1;
+	const size_t blockStep = (blocks + MaxScanBlocks - 1) / MaxScanBlocks;
+
+	const uint64_t scanned = (Index[last].FirstRecord + Index[last].Count - Index[first].FirstRecord) / blockStep;
+	const uint64_t budget = (uint64_t)(store.GetCapacity() < Budget ? store.GetCapacity() : Budget);
+	const uint64_t groups = (budget / 4) ? budget / 4 : 1;
+
+	// each group of stride samples becomes at most 4 rows, the min and max of position and VIN
+	const uint64_t stride = (scanned <= budget) ? 1 : (scanned + groups - 1) / groups;
+
+	RecordedSample group[4];
+	uint64_t inGroup = 0;
+
+	auto flush = [&]() {
+
+		if (inGroup == 0) {
+			return;
+		}
+
+		// the extremes in time order, without repeats
+		const RecordedSample* rows[4] = { &group[0], &group[1], &group[2], &group[3] };
+
+		for (int i = 1; i < 4; i++) {
+			for (int j = i; j > 0 && rows[j]->Time < rows[j - 1]->Time; j--) {
+				const RecordedSample* swap = rows[j];
+				rows[j] = rows[j - 1];
+				rows[j - 1] = swap;
+			}
+		}
+
+		for (int i = 0; i < 4; i++) {
+			if (i == 0 || rows[i]->Time != rows[i - 1]->Time) {
+				store.Add(ToRow(*rows[i]));
+			}
+		}
+
+		inGroup = 0;
+	};
+
+	for (size_t b = first; b <= last; b += blockStep) {
+
+		ForEachSample(Index[b], [&](const RecordedSample& sample) {
+
+			if (sample.Time < from || sample.Time > to) {
+				return;
+			}
+
+			if (stride == 1) {
+				store.Add(ToRow(sample));
+				return;
+			}
+
+			// 0 min position, 1 max position, 2 min VIN, 3 max VIN
+			if (inGroup == 0) {
+				group[0] = group[1] = group[2] = group[3] = sample;
+			}
+			else {
+				if (sample.CurrentPosition < group[0].CurrentPosition) {
+					group[0] = sample;
+				}
+
+				if (sample.CurrentPosition > group[1].CurrentPosition) {
+					group[1] = sample;
+				}
+
+				if (sample.VinVoltage < group[2].VinVoltage) {
+					group[2] = sample;
+				}
+
+				if (sample.VinVoltage > group[3].VinVoltage) {
+					group[3] = sample;
+				}
+			}
+
+			if (++inGroup == stride) {
+				flush();
+			}
+		});
+	}
+
+	flush();
+
+	return stride > 1 || blockStep > 1;
+}
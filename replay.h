@@ -0,0 +1,82 @@
+#pragma once
+
+// read back a log written by Recorder. the file is memory mapped and only the block
+// headers are walked on open, so a large capture opens straight away and pages are
+// only read in for the span being looked at
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "recorder.h"
+#include "telemetry.h"
+
+class Replay {
+
+public:
+
+	// most rows Load() puts in a store, longer spans are reduced to min/max rows
+	static constexpr int Budget = 200000;
+
+	// most blocks Load() reads for one span, past that it reads an even spread of them
+	static constexpr size_t MaxScanBlocks = 4096;
+
+	Replay() {}
+	~Replay() { Close(); }
+
+	Replay(const Replay&) = delete;
+	Replay& operator=(const Replay&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+
+	const std::string& GetPath() const { return Path; }
+	const std::string& GetError() const { return Error; }
+
+	double StartTime() const { return Index.empty() ? 0 : Index.front().FirstTime; }
+	double EndTime() const { return Index.empty() ? 0 : Index.back().LastTime; }
+
+	uint64_t SampleCount() const { return Index.empty() ? 0 : Index.back().FirstRecord + Index.back().Count; }
+	uint64_t FileSize() const { return Size; }
+
+	// replace store's contents with the samples between from and to, true if any were
+	// skipped or merged to stay inside Budget
+	bool Load(TelemetryStore& store, double from, double to) const;
+
+private:
+
+	// one entry per block, the sparse time index
+	struct Entry {
+		uint64_t Offset;
+		uint32_t Bytes;
+		uint32_t Count;
+		uint64_t FirstRecord;
+		double FirstTime;
+		double LastTime;
+	};
+
+	bool Map(const std::string& path);
+	void Unmap();
+
+	// first block that ends at or after t
+	size_t Seek(double t) const;
+
+	// calls f(const RecordedSample&) for every sample in block
+	template <typename F>
+	void ForEachSample(const Entry& block, F f) const;
+
+	std::string Path;
+	std::string Error;
+
+	const uint8_t* Data = nullptr;
+	uint64_t Size = 0;
+
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+
+	std::vector<Entry> Index;
+};
@@ -0,0 +1,198 @@
+#include "settings_diff.h"
+
+#include <string>
+
+// one stored setting, Size bytes little endian at Address in the TIC's settings block
+struct SettingField {
+	uint8_t Address;
+	uint8_t Size;
+
+	// has an immediate command, only stored by CommitSettings()
+	bool bRuntime;
+
+	uint32_t (*Get)(const tic_settings*);
+	void (*Set)(tic_settings*, uint32_t);
+};
+
+// getter and setter for tic_settings_get_/set_<name>, through uint32_t so the table is one type
+#define SETTING_FIELD(address, size, runtime, name) { address, size, runtime, \
+	[](const tic_settings* s) { return (uint32_t)tic_settings_get_##name(s); }, \
+	[](tic_settings* s, uint32_t value) { tic_settings_set_##name(s, (decltype(tic_settings_get_##name(s)))value); } }
+
+// the plainly encoded settings. bit packed ones (options byte, pin config, serial)
+// and the ones that need converting (baud rate, current during error) aren't here
+static const SettingField Fields[] = {
+	SETTING_FIELD(TIC_SETTING_CONTROL_MODE,					1, false, control_mode),
+	SETTING_FIELD(TIC_SETTING_DISABLE_SAFE_START,			1, false, disable_safe_start),
+	SETTING_FIELD(TIC_SETTING_IGNORE_ERR_LINE_HIGH,			1, false, ignore_err_line_high),
+	SETTING_FIELD(TIC_SETTING_AUTO_CLEAR_DRIVER_ERROR,		1, false, auto_clear_driver_error),
+	SETTING_FIELD(TIC_SETTING_COMMAND_TIMEOUT,				2, false, command_timeout),
+	SETTING_FIELD(TIC_SETTING_VIN_CALIBRATION,				2, false, vin_calibration),
+	SETTING_FIELD(TIC_SETTING_INVERT_MOTOR_DIRECTION,		1, false, invert_motor_direction),
+	SETTING_FIELD(TIC_SETTING_INPUT_SCALING_DEGREE,			1, false, input_scaling_degree),
+	SETTING_FIELD(TIC_SETTING_INPUT_INVERT,					1, false, input_invert),
+	SETTING_FIELD(TIC_SETTING_INPUT_MIN,					2, false, input_min),
+	SETTING_FIELD(TIC_SETTING_INPUT_NEUTRAL_MIN,			2, false, input_neutral_min),
+	SETTING_FIELD(TIC_SETTING_INPUT_NEUTRAL_MAX,			2, false, input_neutral_max),
+	SETTING_FIELD(TIC_SETTING_INPUT_MAX,					2, false, input_max),
+	SETTING_FIELD(TIC_SETTING_OUTPUT_MIN,					4, false, output_min),
+	SETTING_FIELD(TIC_SETTING_INPUT_AVERAGING_ENABLED,		1, false, input_averaging_enabled),
+	SETTING_FIELD(TIC_SETTING_INPUT_HYSTERESIS,				2, false, input_hysteresis),
+	SETTING_FIELD(TIC_SETTING_OUTPUT_MAX,					4, false, output_max),
+	SETTING_FIELD(TIC_SETTING_ENCODER_POSTSCALER,			4, false, encoder_postscaler),
+	SETTING_FIELD(TIC_SETTING_CURRENT_LIMIT,				1, true,  current_limit_code),
+	SETTING_FIELD(TIC_SETTING_STEP_MODE,					1, true,  step_mode),
+	SETTING_FIELD(TIC_SETTING_DECAY_MODE,					1, true,  decay_mode),
+	SETTING_FIELD(TIC_SETTING_STARTING_SPEED,				4, true,  starting_speed),
+	SETTING_FIELD(TIC_SETTING_MAX_SPEED,					4, true,  max_speed),
+	SETTING_FIELD(TIC_SETTING_MAX_DECEL,					4, true,  max_decel),
+	SETTING_FIELD(TIC_SETTING_MAX_ACCEL,					4, true,  max_accel),
+	SETTING_FIELD(TIC_SETTING_SOFT_ERROR_RESPONSE,			1, false, soft_error_response),
+	SETTING_FIELD(TIC_SETTING_SOFT_ERROR_POSITION,			4, false, soft_error_position),
+	SETTING_FIELD(TIC_SETTING_ENCODER_PRESCALER,			4, false, encoder_prescaler),
+	SETTING_FIELD(TIC_SETTING_ENCODER_UNLIMITED,			1, false, encoder_unlimited),
+	SETTING_FIELD(TIC_SETTING_SERIAL_RESPONSE_DELAY,		1, false, serial_response_delay),
+	SETTING_FIELD(TIC_SETTING_HOMING_SPEED_TOWARDS,			4, false, homing_speed_towards),
+	SETTING_FIELD(TIC_SETTING_HOMING_SPEED_AWAY,			4, false, homing_speed_away),
+};
+
+#undef SETTING_FIELD
+
+static uint8_t ByteOf(const SettingField& field, const tic_settings* s, int index)
+{
+	return (uint8_t)(field.Get(s) >> (8 * index));
+}
+
+void SendRuntimeSettings(TicDevice& device, const tic::settings& settings)
+{
+	const tic_settings* s = settings.get_pointer();
+
+	// step mode first, the speeds and accelerations are in its microsteps
+	device.set_step_mode(tic_settings_get_step_mode(s));
+	device.set_decay_mode(tic_settings_get_decay_mode(s));
+	device.set_current_limit(tic_settings_get_current_limit(s));
+	device.set_max_speed(tic_settings_get_max_speed(s));
+	device.set_starting_speed(tic_settings_get_starting_speed(s));
+	device.set_max_accel(tic_settings_get_max_accel(s));
+	device.set_max_decel(tic_settings_get_max_decel(s));
+}
+
+// store next over stored, a byte at a time if every difference is in Fields, otherwise the
+// whole block. true if anything but a runtime field was written, which needs a reinitialize
+static bool Store(TicDevice& device, const tic::settings& stored, const tic::settings& next)
+{
+	// any difference left once every field in the table matches isn't one we can write a byte at a time
+	tic::settings rest = next;
+
+	for (const SettingField& field : Fields) {
+		field.Set(rest.get_pointer(), field.Get(stored.get_pointer()));
+	}
+
+	const bool bBytes = device.has_setting_bytes() && rest.to_string() == stored.to_string();
+
+	if (!bBytes) {
+
+		if (next.to_string() == stored.to_string()) {
+			return false;
+		}
+
+		device.set_settings(next);
+		return true;
+	}
+
+	bool bReinitialise = false;
+
+	for (const SettingField& field : Fields) {
+		for (int i = 0; i < field.Size; i++) {
+
+			const uint8_t value = ByteOf(field, next.get_pointer(), i);
+
+			if (value != ByteOf(field, stored.get_pointer(), i)) {
+				device.set_setting_byte((uint8_t)(field.Address + i), value);
+				bReinitialise |= !field.bRuntime;
+			}
+		}
+	}
+
+	return bReinitialise;
+}
+
+tic::settings WriteSettings(TicDevice& device, const tic::settings& stored, const tic::settings& settings)
+{
+	// what set_settings would have written
+	tic::settings wanted = settings;
+	wanted.fix();
+
+	// what the TIC should end up with stored, the runtime fields stay as they were
+	tic::settings next = wanted;
+
+	for (const SettingField& field : Fields) {
+		if (field.bRuntime) {
+			field.Set(next.get_pointer(), field.Get(stored.get_pointer()));
+		}
+	}
+
+	// stored settings take effect, and put the live ones back to what was stored
+	if (Store(device, stored, next)) {
+		device.reinitialize();
+	}
+
+	SendRuntimeSettings(device, wanted);
+
+	return next;
+}
+
+tic::settings CommitSettings(TicDevice& device, const tic::settings& stored, const tic::settings& settings)
+{
+	tic::settings wanted = settings;
+	wanted.fix();
+
+	// runtime fields are already live, only a change to something else needs a reinitialize
+	if (Store(device, stored, wanted)) {
+		device.reinitialize();
+	}
+
+	SendRuntimeSettings(device, wanted);
+
+	return wanted;
+}
+
+int ChangedFields(const tic::settings& stored, const tic::settings& settings)
+{
+	int changed = 0;
+
+	// the rest as it'd be with every field in the table matching, like Store()
+	tic::settings rest = settings;
+
+	for (const SettingField& field : Fields) {
+		if (field.Get(stored.get_pointer()) != field.Get(settings.get_pointer())) {
+			field.Set(rest.get_pointer(), field.Get(stored.get_pointer()));
+			changed++;
+		}
+	}
+
+	if (rest.to_string() != stored.to_string()) {
+		changed++;
+	}
+
+	return changed;
+}
+
+bool PatchSettingByte(tic::settings& settings, uint8_t address, uint8_t value)
+{
+	for (const SettingField& field : Fields) {
+
+		if (address < field.Address || address >= field.Address + field.Size) {
+			continue;
+		}
+
+		const int shift = 8 * (address - field.Address);
+		const uint32_t old = field.Get(settings.get_pointer());
+
+		field.Set(settings.get_pointer(), (old & ~(0xFFu << shift)) | ((uint32_t)value << shift));
+
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// writes settings to a TIC as the difference from what it already has stored, rather than
+// set_settings + reinitialize + get_settings for every slider move. the runtime fields
+// (speeds, accelerations, current limit, step and decay mode) go as their immediate commands
+// and only touch the TIC's EEPROM when committed, other fields are written a byte at a time with
+// TIC_CMD_SET_SETTING, and only a field with no known address falls back to set_settings
+
+#include <cstdint>
+
+#include "tic_device.h"
+
+// the runtime fields of settings as immediate commands, nothing stored. behind a
+// TicCommandQueue only the ones that changed since they were last sent go
+void SendRuntimeSettings(TicDevice& device, const tic::settings& settings);
+
+// have the TIC run with settings, where stored is what it has stored now.
+// returns what it has stored afterwards, stored with any non-runtime changes
+tic::settings WriteSettings(TicDevice& device, const tic::settings& stored, const tic::settings& settings);
+
+// the same but the runtime fields are stored too, for keeping what was tuned live.
+// doesn't reinitialize, and so doesn't interrupt motion, unless something else changed.
+// returns what the TIC has stored afterwards
+tic::settings CommitSettings(TicDevice& device, const tic::settings& stored, const tic::settings& settings);
+
+// fields that differ between stored and settings, nothing sent. differences outside the
+// fields WriteSettings() knows, in pin config say, count as one more
+int ChangedFields(const tic::settings& stored, const tic::settings& settings);
+
+// set the field holding address in settings as though that byte had been written to the
+// TIC, false if no field WriteSettings() writes holds it
+bool PatchSettingByte(tic::settings& settings, uint8_t address, uint8_t value);
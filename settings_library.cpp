@@ -0,0 +1,132 @@
+#include "settings_library.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+std::string SettingsLibrary::PathOf(const std::string& name) const
+{
+	return (fs::path(Directory) / (name + Extension)).string();
+}
+
+bool SettingsLibrary::Open(const std::string& directory)
+{
+	Directory = directory;
+	Profiles.clear();
+
+	Error.clear();
+	Warnings.clear();
+
+	std::error_code code;
+
+	if (!fs::is_directory(directory, code)) {
+		return true;
+	}
+
+	for (const fs::directory_entry& entry : fs::directory_iterator(directory, code)) {
+
+		if (!entry.is_regular_file() || entry.path().extension() != Extension) {
+			continue;
+		}
+
+		const std::string name = entry.path().stem().string();
+
+		std::ifstream file(entry.path());
+		std::stringstream text;
+		text << file.rdbuf();
+
+		try {
+			tic::settings settings = tic::settings::read_from_string(text.str());
+
+			std::string warnings;
+			settings.fix(&warnings);
+
+			if (!warnings.empty()) {
+				Warnings += name + ": " + warnings;
+			}
+
+			Profiles[name] = std::move(settings);
+		}
+		catch (const std::exception& error) {
+			Error += name + ": " + error.what() + "\n";
+		}
+	}
+
+	if (code) {
+		Error = "can't read " + directory + ": " + code.message();
+	}
+
+	return Error.empty();
+}
+
+std::vector<std::string> SettingsLibrary::GetNames() const
+{
+	std::vector<std::string> names;
+
+	for (const auto& profile : Profiles) {
+		names.push_back(profile.first);
+	}
+
+	return names;
+}
+
+const tic::settings* SettingsLibrary::Find(const std::string& name) const
+{
+	auto it = Profiles.find(name);
+	return (it != Profiles.end()) ? &it->second : nullptr;
+}
+
+bool SettingsLibrary::Save(const std::string& name, const tic::settings& settings)
+{
+	Error.clear();
+	Warnings.clear();
+
+	if (name.empty() || name.find_first_of("/\\:.") != std::string::npos) {
+		Error = "'" + name + "' can't be a file name";
+		return false;
+	}
+
+	try {
+		tic::settings fixed = settings;
+		fixed.fix(&Warnings);
+
+		std::error_code code;
+		fs::create_directories(Directory, code);
+
+		std::ofstream file(PathOf(name), std::ios::trunc);
+
+		if (!(file << fixed.to_string())) {
+			Error = "can't write " + PathOf(name);
+			return false;
+		}
+
+		Profiles[name] = std::move(fixed);
+	}
+	catch (const std::exception& error) {
+		Error = error.what();
+		return false;
+	}
+
+	return true;
+}
+
+bool SettingsLibrary::Remove(const std::string& name)
+{
+	Error.clear();
+
+	if (Profiles.erase(name) == 0) {
+		Error = "no profile '" + name + "'";
+		return false;
+	}
+
+	std::error_code code;
+
+	if (!fs::remove(PathOf(name), code)) {
+		Error = "can't remove " + PathOf(name);
+		return false;
+	}
+
+	return true;
+}
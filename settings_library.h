@@ -0,0 +1,50 @@
+#pragma once
+
+// named tuning sets, one tic_settings_to_string file each in a directory. every file is
+// read and fixed once into an in-memory index, so switching a TIC to a profile is a lookup
+// plus WriteSettings(), only the fields that differ from what the TIC has stored go over USB
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tic_device.h"
+
+class SettingsLibrary {
+
+public:
+
+	// the Tic Control Center saves settings files as text too, so they load either way
+	static constexpr const char* Extension = ".txt";
+
+	// index every profile in directory, replacing what was indexed. a missing directory is
+	// an empty library, it's created by the first Save(). false if any file didn't read
+	bool Open(const std::string& directory);
+
+	const std::string& GetDirectory() const { return Directory; }
+
+	// in name order
+	std::vector<std::string> GetNames() const;
+
+	// nullptr if there's no such profile
+	const tic::settings* Find(const std::string& name) const;
+
+	// fixed, written to the directory and indexed, replacing one of the same name
+	bool Save(const std::string& name, const tic::settings& settings);
+
+	bool Remove(const std::string& name);
+
+	// why the last call failed, and what tic_settings_fix changed on the last Open() or Save()
+	const std::string& GetError() const { return Error; }
+	const std::string& GetWarnings() const { return Warnings; }
+
+private:
+
+	std::string PathOf(const std::string& name) const;
+
+	std::string Directory;
+	std::map<std::string, tic::settings> Profiles;
+
+	std::string Error;
+	std::string Warnings;
+};
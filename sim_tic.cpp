@@ -0,0 +1,302 @@
+#include "sim_tic.h"
+
+#include <cmath>
+
+#include "settings_diff.h"
+
+// largest integration step, keeps the stop-at-target decision accurate at high speed
+static constexpr double MaxStep = 0.0005;
+
+// TIC units to microsteps/s and microsteps/s^2
+static constexpr double SpeedScale = 1.0 / 10000.0;
+static constexpr double AccelScale = 1.0 / 100.0;
+
+// every simulator's clock starts here
+static const std::chrono::steady_clock::time_point Origin = std::chrono::steady_clock::now();
+
+std::chrono::steady_clock::time_point SimTicDevice::Now() const
+{
+	using Clock = std::chrono::steady_clock;
+
+	const double scale = TimeScale.load();
+	const double elapsed = (scale > 0) ? std::chrono::duration<double>(Clock::now() - Origin).count() * scale : FrozenTime.load();
+
+	return Origin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(elapsed));
+}
+
+SimTicDevice::SimTicDevice()
+{
+	Settings = tic::settings::create();
+	Settings.set_product(TIC_PRODUCT_T825);
+	Settings.fill_with_defaults();
+
+	reinitialize();
+
+	bEnergized = false;
+	LastSync = std::chrono::steady_clock::now();
+
+	UpdateErrors();
+}
+
+void SimTicDevice::reinitialize()
+{
+	const tic_settings* s = Settings.get_pointer();
+
+	MaxSpeed		= tic_settings_get_max_speed(s);
+	StartingSpeed	= tic_settings_get_starting_speed(s);
+	MaxAccel		= tic_settings_get_max_accel(s);
+	MaxDecel		= tic_settings_get_max_decel(s);
+	CurrentLimit	= tic_settings_get_current_limit(s);
+	StepMode		= tic_settings_get_step_mode(s);
+	DecayMode		= tic_settings_get_decay_mode(s);
+}
+
+void SimTicDevice::set_setting_byte(uint8_t address, uint8_t value)
+{
+	// bytes outside the fields WriteSettings() knows are ignored, it never sends them
+	PatchSettingByte(Settings, address, value);
+}
+
+void SimTicDevice::Sync()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double elapsed = std::chrono::duration<double>(now - LastSync).count();
+
+	LastSync = now;
+
+	if (TimeScale.load() > 0) {
+		Advance(elapsed * TimeScale.load());
+	}
+}
+
+void SimTicDevice::Advance(double dt)
+{
+	while (dt > 0) {
+		const double step = (dt < MaxStep) ? dt : MaxStep;
+
+		Step(step);
+		dt -= step;
+	}
+
+	FrozenTime.store(SimTime);
+}
+
+void SimTicDevice::set_step_mode(uint8_t step_mode)
+{
+	Sync();
+
+	// like the TIC, the position count carries on in the new microsteps
+	StepMode = step_mode;
+}
+
+void SimTicDevice::Step(double dt)
+{
+	SimTime += dt;
+
+	const double vmax = MaxSpeed * SpeedScale;
+	const double vstart = StartingSpeed * SpeedScale;
+	const double accel = MaxAccel * AccelScale;
+
+	// a decel of 0 means use the accel limit, same as the firmware
+	const double decel = (MaxDecel ? MaxDecel : MaxAccel) * AccelScale;
+
+	const double previous = Velocity;
+
+	if (!bEnergized || bSafeStart) {
+		Velocity = 0;
+	}
+	else {
+		double desired;
+
+		if (bVelocityMode) {
+			desired = TargetVelocity * SpeedScale;
+		}
+		else {
+			const double distance = TargetPosition - Position;
+
+			// distance needed to stop from the current speed
+			const double stopping = (Velocity * Velocity) / (2.0 * (decel > 0 ? decel : 1.0));
+
+			if (fabs(distance) < 0.5 && fabs(Velocity) <= vstart + decel * dt) {
+				Position = TargetPosition;
+				desired = 0;
+				Velocity = 0;
+			}
+			else if ((distance > 0) == (Velocity > 0) && Velocity != 0 && stopping >= fabs(distance)) {
+				desired = 0;
+			}
+			else {
+				desired = (distance > 0) ? vmax : -vmax;
+			}
+		}
+
+		desired = (desired > vmax) ? vmax : ((desired < -vmax) ? -vmax : desired);
+
+		// below the starting speed the TIC can jump straight to the new speed
+		if (fabs(desired) <= vstart && fabs(Velocity) <= vstart) {
+			Velocity = desired;
+		}
+		else {
+			const bool speeding_up = fabs(desired) > fabs(Velocity) && ((desired >= 0) == (Velocity >= 0));
+			const double limit = (speeding_up ? accel : decel) * dt;
+			const double change = desired - Velocity;
+
+			if (fabs(change) <= limit) {
+				Velocity = desired;
+			}
+			else {
+				Velocity += (change > 0) ? limit : -limit;
+			}
+
+			if (speeding_up && fabs(Velocity) < vstart) {
+				Velocity = (desired > 0) ? vstart : -vstart;
+			}
+		}
+
+		Position += Velocity * dt;
+
+		// don't overshoot a position target inside one step
+		if (!bVelocityMode) {
+			if ((previous >= 0 && Velocity >= 0 && Position > TargetPosition && Position - Velocity * dt <= TargetPosition) ||
+				(previous <= 0 && Velocity <= 0 && Position < TargetPosition && Position - Velocity * dt >= TargetPosition)) {
+				Position = TargetPosition;
+				Velocity = 0;
+			}
+		}
+	}
+
+	Accel = (dt > 0) ? (Velocity - previous) / dt : 0;
+
+	// coil current sags the supply, holding draws the set limit, motion and acceleration add to it.
+	// the motor sees full steps, the same TIC speed is half as fast a step mode finer
+	double amps = 0;
+	double ripple = 0;
+
+	if (bEnergized) {
+		const double microsteps = Microsteps(StepMode);
+		const double steps = fabs(Velocity) / microsteps;
+		const double moving = (RatedStepRate > 0) ? steps / RatedStepRate : 0;
+		const double pushing = (accel > 0) ? fabs(Accel) / accel : 0;
+
+		// half step at 100% drives both coils fully on the in-between steps
+		const double holding = (StepMode == TIC_STEP_MODE_MICROSTEP2_100P) ? 0.85 : 0.6;
+
+		amps = CurrentLimit / 1000.0 * (holding + 0.25 * (moving > 1 ? 1 : moving) + 0.35 * (pushing > 1 ? 1 : pushing));
+
+		// each step is a current step, coarser modes pull the supply in bigger jerks
+		if (steps > 0) {
+			ripple = SourceResistance * amps * 0.2 / microsteps * sin(Position / microsteps * 3.14159265358979 / 2.0);
+		}
+	}
+
+	Vin = NominalVin - SourceResistance * amps + ripple + NextNoise() * 0.01;
+}
+
+double SimTicDevice::NextNoise()
+{
+	// xorshift32, deterministic so runs are repeatable
+	NoiseState ^= NoiseState << 13;
+	NoiseState ^= NoiseState >> 17;
+	NoiseState ^= NoiseState << 5;
+
+	return (NoiseState / 4294967295.0) * 2.0 - 1.0;
+}
+
+void SimTicDevice::UpdateErrors()
+{
+	ErrorStatus = 0;
+
+	if (!bEnergized) {
+		ErrorStatus |= (1 << TIC_ERROR_INTENTIONALLY_DEENERGIZED);
+	}
+
+	if (bEnergized && bSafeStart) {
+		ErrorStatus |= (1 << TIC_ERROR_SAFE_START_VIOLATION);
+	}
+
+	ErrorsOccurred |= ErrorStatus;
+}
+
+void SimTicDevice::get_variables(TicSample& sample)
+{
+	Sync();
+
+	sample.TargetPosition	= bVelocityMode ? 0 : TargetPosition;
+	sample.CurrentPosition	= (int32_t)floor(Position + 0.5);
+	sample.CurrentVelocity	= (int32_t)(Velocity / SpeedScale);
+	sample.MaxSpeed			= MaxSpeed;
+	sample.StartingSpeed	= StartingSpeed;
+	sample.MaxAccel			= MaxAccel;
+	sample.MaxDecel			= MaxDecel;
+	sample.VinVoltage		= (uint32_t)(Vin * 1000.0);
+	sample.CurrentLimit		= CurrentLimit;
+	sample.ErrorsOccurred	= ErrorsOccurred;
+	sample.ErrorStatus		= ErrorStatus;
+	sample.StepMode			= StepMode;
+
+	if (!bEnergized) {
+		sample.OperationState = TIC_OPERATION_STATE_DEENERGIZED;
+	}
+	else if (ErrorStatus) {
+		sample.OperationState = TIC_OPERATION_STATE_SOFT_ERROR;
+	}
+	else {
+		sample.OperationState = TIC_OPERATION_STATE_NORMAL;
+	}
+}
+
+void SimTicDevice::set_target_position(int32_t position)
+{
+	Sync();
+
+	bVelocityMode = false;
+	TargetPosition = position;
+}
+
+void SimTicDevice::set_target_velocity(int32_t velocity)
+{
+	Sync();
+
+	bVelocityMode = true;
+	TargetVelocity = velocity;
+}
+
+void SimTicDevice::halt_and_hold()
+{
+	Sync();
+
+	Velocity = 0;
+	bVelocityMode = true;
+	TargetVelocity = 0;
+}
+
+void SimTicDevice::energize()
+{
+	Sync();
+
+	if (!bEnergized) {
+		bEnergized = true;
+		bSafeStart = true;
+	}
+
+	UpdateErrors();
+}
+
+void SimTicDevice::deenergize()
+{
+	Sync();
+
+	bEnergized = false;
+	Velocity = 0;
+
+	UpdateErrors();
+}
+
+void SimTicDevice::exit_safe_start()
+{
+	Sync();
+
+	bSafeStart = false;
+
+	UpdateErrors();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+// software TIC for running without hardware, models the TIC's own motion planner
+// from max speed / starting speed / accel / decel, energise and safe start state,
+// and a VIN that sags with load
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "tic_device.h"
+
+class SimTicDevice : public TicDevice {
+
+public:
+
+	SimTicDevice();
+
+	// 1 runs in step with the wall clock, > 1 faster than real time,
+	// 0 freezes the clock so only Advance() moves it. set before anything reads Now()
+	void SetTimeScale(double scale) { TimeScale.store(scale); }
+	double GetTimeScale() const { return TimeScale.load(); }
+
+	// wall time since a start every simulator shares, times the time scale, so several at the
+	// same scale are on one clock. frozen, it's that start plus GetTime()
+	std::chrono::steady_clock::time_point Now() const override;
+
+	// step the model by dt simulated seconds
+	void Advance(double dt);
+
+	// simulated seconds since construction
+	double GetTime() const { return SimTime; }
+
+	// supply voltage with no load, volts
+	double NominalVin = 12.0;
+
+	// effective supply + wiring resistance, ohms
+	double SourceResistance = 0.35;
+
+	// full steps a second the motor is rated to, its current draw and the ripple it puts on
+	// VIN follow the speed in full steps, so the step mode matters
+	double RatedStepRate = 1000.0;
+
+	std::string get_name() const override { return "Simulated T825"; }
+
+	void get_variables(TicSample& sample) override;
+
+	void set_target_position(int32_t position) override;
+	void set_target_velocity(int32_t velocity) override;
+	void halt_and_hold() override;
+
+	void energize() override;
+	void deenergize() override;
+	void exit_safe_start() override;
+
+	// no command timeout modelled
+	void reset_command_timeout() override {}
+
+	void set_max_speed(uint32_t max_speed) override { MaxSpeed = max_speed; }
+	void set_starting_speed(uint32_t starting_speed) override { StartingSpeed = starting_speed; }
+	void set_max_accel(uint32_t max_accel) override { MaxAccel = max_accel; }
+	void set_max_decel(uint32_t max_decel) override { MaxDecel = max_decel; }
+	void set_step_mode(uint8_t step_mode) override;
+	void set_current_limit(uint32_t current_limit) override { CurrentLimit = current_limit; }
+	void set_decay_mode(uint8_t decay_mode) override { DecayMode = decay_mode; }
+
+	tic::settings get_settings() override { return Settings; }
+	void set_settings(const tic::settings& settings) override { Settings = settings; }
+	void set_setting_byte(uint8_t address, uint8_t value) override;
+	bool has_setting_bytes() const override { return true; }
+	void reinitialize() override;
+
+private:
+
+	// bring the simulation up to date with the wall clock
+	void Sync();
+
+	// one integration step, dt small enough for the planner to be stable
+	void Step(double dt);
+
+	void UpdateErrors();
+
+	double NextNoise();
+
+	tic::settings Settings;
+
+	std::chrono::steady_clock::time_point LastSync;
+	std::atomic<double> TimeScale{ 1.0 };
+	double SimTime = 0;
+
+	// SimTime for Now() while frozen, read from other threads
+	std::atomic<double> FrozenTime{ 0 };
+
+	// planner state, position in microsteps, velocity in microsteps/s
+	double Position = 0;
+	double Velocity = 0;
+	double Accel = 0;
+
+	bool bVelocityMode = false;
+	int32_t TargetPosition = 0;
+	int32_t TargetVelocity = 0;
+
+	bool bEnergized = false;
+	bool bSafeStart = true;
+
+	// live parameters in TIC units, reloaded from Settings by reinitialize()
+	uint32_t MaxSpeed = 0;
+	uint32_t StartingSpeed = 0;
+	uint32_t MaxAccel = 0;
+	uint32_t MaxDecel = 0;
+	uint32_t CurrentLimit = 0;
+	uint8_t StepMode = 0;
+	uint8_t DecayMode = 0;
+
+	uint16_t ErrorStatus = 0;
+	uint32_t ErrorsOccurred = 0;
+
+	double Vin = 12.0;
+	uint32_t NoiseState = 0x2545F491;
+};
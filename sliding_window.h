@@ -0,0 +1,126 @@
+#pragma once
+
+// sliding window statistics, all amortised O(1) per sample
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+// sliding window min or max, monotonic deque held in a fixed ring so it never allocates after construction
+template <bool IsMax>
+struct MonotonicWindow {
+
+	struct Entry {
+		uint64_t Index;
+		double Value;
+	};
+
+	std::vector<Entry> Ring;
+	size_t Front = 0;
+	size_t Count = 0;
+
+	explicit MonotonicWindow(size_t window = 1)
+	{
+		Ring.resize(window + 1);
+	}
+
+	void Reset()
+	{
+		Front = 0;
+		Count = 0;
+	}
+
+	// index is a running sample counter, entries older than index - window are dropped
+	void Push(uint64_t index, double value, size_t window)
+	{
+		// anything behind us that can never be the extreme again goes
+		while (Count && Dominated(Back().Value, value)) {
+			Count--;
+		}
+
+		Ring[(Front + Count) % Ring.size()] = { index, value };
+		Count++;
+
+		while (Count && Ring[Front].Index + window <= index) {
+			Front = (Front + 1) % Ring.size();
+			Count--;
+		}
+	}
+
+	double Get() const
+	{
+		return Count ? Ring[Front].Value : (IsMax ? -DBL_MAX : DBL_MAX);
+	}
+
+private:
+
+	Entry& Back()
+	{
+		return Ring[(Front + Count - 1) % Ring.size()];
+	}
+
+	static bool Dominated(double older, double newer)
+	{
+		return IsMax ? (older <= newer) : (older >= newer);
+	}
+};
+
+// running average, min and max over the last Window values pushed, the owner holds the values
+// and hands back the one falling out of the window so nothing here ever scans
+struct SlidingStats {
+
+	explicit SlidingStats(size_t window = 1500) : Window(window), MinWindow(window), MaxWindow(window) {}
+
+	void Push(double value)
+	{
+		Sum += value;
+
+		if (Count < Window) {
+			Count++;
+		}
+
+		MinWindow.Push(Added, value, Window);
+		MaxWindow.Push(Added, value, Window);
+		Added++;
+	}
+
+	// value that just dropped out of the window, call before Push() of its replacement
+	void Evict(double value)
+	{
+		Sum -= value;
+
+		if (Count) {
+			Count--;
+		}
+	}
+
+	// running sums drift as values are added and removed, owner recomputes once in a while
+	void SetSum(double sum)
+	{
+		Sum = sum;
+	}
+
+	void Reset()
+	{
+		Sum = 0;
+		Count = 0;
+
+		MinWindow.Reset();
+		MaxWindow.Reset();
+	}
+
+	double Avg() const { return Count ? Sum / Count : 0; }
+	double Min() const { return MinWindow.Get(); }
+	double Max() const { return MaxWindow.Get(); }
+
+	size_t Window;
+
+private:
+
+	MonotonicWindow<false> MinWindow;
+	MonotonicWindow<true> MaxWindow;
+
+	double Sum = 0;
+	size_t Count = 0;
+	uint64_t Added = 0;
+};
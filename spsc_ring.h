@@ -0,0 +1,66 @@
+#pragma once
+
+// lock-free single producer / single consumer ring, used to hand samples from
+// the acquisition thread to the GUI without either side ever blocking
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+template <typename T, size_t Capacity>
+class SpscRing {
+
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+
+	// producer side, returns false if the consumer has fallen behind and the ring is full
+	bool Push(const T& item)
+	{
+		const size_t head = Head.load(std::memory_order_relaxed);
+
+		if (head - Tail.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+
+		Data[head & (Capacity - 1)] = item;
+		Head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// consumer side, returns false when empty
+	bool Pop(T& item)
+	{
+		const size_t tail = Tail.load(std::memory_order_relaxed);
+
+		if (tail == Head.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		item = Data[tail & (Capacity - 1)];
+		Tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// approximate, only exact when called from one of the two owning threads
+	size_t Size() const
+	{
+		return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire);
+	}
+
+	bool Empty() const
+	{
+		return Size() == 0;
+	}
+
+private:
+
+	// keep producer and consumer indices on separate cache lines
+	alignas(64) std::atomic<size_t> Head{ 0 };
+	alignas(64) std::atomic<size_t> Tail{ 0 };
+
+	alignas(64) T Data[Capacity];
+};
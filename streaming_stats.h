@@ -0,0 +1,257 @@
+#pragma once
+
+// statistics over every value of an unbounded stream in fixed memory, O(1) per value
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// count, mean, variance (Welford, no cancellation on long runs), min and max
+class RunningStats {
+
+public:
+
+	void Push(double value)
+	{
+		Count++;
+
+		const double delta = value - Mean;
+
+		Mean += delta / Count;
+		M2 += delta * (value - Mean);
+
+		if (value < Low) {
+			Low = value;
+		}
+
+		if (value > High) {
+			High = value;
+		}
+	}
+
+	void Reset() { *this = RunningStats(); }
+
+	uint64_t Samples() const { return Count; }
+	double Avg() const { return Mean; }
+
+	// sample variance
+	double Variance() const { return Count > 1 ? M2 / (Count - 1) : 0; }
+	double StdDev() const { return sqrt(Variance()); }
+
+	double Min() const { return Count ? Low : 0; }
+	double Max() const { return Count ? High : 0; }
+
+private:
+
+	uint64_t Count = 0;
+	double Mean = 0;
+	double M2 = 0;
+	double Low = DBL_MAX;
+	double High = -DBL_MAX;
+};
+
+// one quantile by the P-squared algorithm (Jain and Chlamtac), five markers whatever the stream length
+class P2Quantile {
+
+public:
+
+	explicit P2Quantile(double quantile = 0.5) : Quantile(quantile) {}
+
+	void Push(double value)
+	{
+		// exact until the markers can be placed
+		if (Count < 5) {
+
+			Heights[Count++] = value;
+
+			if (Count == 5) {
+
+				std::sort(Heights, Heights + 5);
+
+				for (int i = 0; i < 5; i++) {
+					Positions[i] = i;
+				}
+
+				Desired[0] = 0;
+				Desired[1] = 2 * Quantile;
+				Desired[2] = 4 * Quantile;
+				Desired[3] = 2 + 2 * Quantile;
+				Desired[4] = 4;
+			}
+
+			return;
+		}
+
+		Count++;
+
+		// cell the value falls in, the end markers stretch to take it
+		int cell;
+
+		if (value < Heights[0]) {
+			Heights[0] = value;
+			cell = 0;
+		}
+		else if (value >= Heights[4]) {
+			Heights[4] = value;
+			cell = 3;
+		}
+		else {
+			cell = 0;
+
+			while (cell < 3 && value >= Heights[cell + 1]) {
+				cell++;
+			}
+		}
+
+		for (int i = cell + 1; i < 5; i++) {
+			Positions[i]++;
+		}
+
+		const double increments[5] = { 0, Quantile / 2, Quantile, (1 + Quantile) / 2, 1 };
+
+		for (int i = 0; i < 5; i++) {
+			Desired[i] += increments[i];
+		}
+
+		// middle markers move a step towards where they should be, parabolic if it stays in order
+		for (int i = 1; i < 4; i++) {
+
+			const double offset = Desired[i] - Positions[i];
+
+			if ((offset >= 1 && Positions[i + 1] - Positions[i] > 1) || (offset <= -1 && Positions[i - 1] - Positions[i] < -1)) {
+
+				const int step = (offset > 0) ? 1 : -1;
+
+				double height = Parabolic(i, step);
+
+				if (height <= Heights[i - 1] || height >= Heights[i + 1]) {
+					height = Heights[i] + step * (Heights[i + step] - Heights[i]) / (Positions[i + step] - Positions[i]);
+				}
+
+				Heights[i] = height;
+				Positions[i] += step;
+			}
+		}
+	}
+
+	void Reset() { *this = P2Quantile(Quantile); }
+
+	double Get() const
+	{
+		if (Count >= 5) {
+			return Heights[2];
+		}
+
+		if (Count == 0) {
+			return 0;
+		}
+
+		double sorted[5];
+
+		std::copy(Heights, Heights + Count, sorted);
+		std::sort(sorted, sorted + Count);
+
+		return sorted[(size_t)(Quantile * (Count - 1) + 0.5)];
+	}
+
+private:
+
+	double Parabolic(int i, int step) const
+	{
+		const double below = Positions[i] - Positions[i - 1];
+		const double above = Positions[i + 1] - Positions[i];
+
+		return Heights[i] + step / (Positions[i + 1] - Positions[i - 1]) *
+			((below + step) * (Heights[i + 1] - Heights[i]) / above + (above - step) * (Heights[i] - Heights[i - 1]) / below);
+	}
+
+	double Quantile;
+	uint64_t Count = 0;
+
+	double Heights[5] = {};
+	double Positions[5] = {};
+	double Desired[5] = {};
+};
+
+// counts in fixed width bins between Low and High, the same edges every run so runs compare
+class Histogram {
+
+public:
+
+	Histogram(double low, double high, size_t bins) : Low(low), High(high), Counts(bins ? bins : 1) {}
+
+	void Push(double value)
+	{
+		if (value < Low) {
+			Under++;
+		}
+		else if (value >= High) {
+			Over++;
+		}
+		else {
+			Counts[(size_t)((value - Low) / (High - Low) * Counts.size())]++;
+		}
+	}
+
+	void Reset()
+	{
+		std::fill(Counts.begin(), Counts.end(), 0);
+		Under = 0;
+		Over = 0;
+	}
+
+	double GetLow() const { return Low; }
+	double GetHigh() const { return High; }
+	double BinWidth() const { return (High - Low) / Counts.size(); }
+
+	const std::vector<uint64_t>& Bins() const { return Counts; }
+
+	// values that fell outside the range
+	uint64_t Below() const { return Under; }
+	uint64_t Above() const { return Over; }
+
+private:
+
+	double Low;
+	double High;
+
+	std::vector<uint64_t> Counts;
+	uint64_t Under = 0;
+	uint64_t Over = 0;
+};
+
+// everything above for one stream, p1 / p50 / p99 for the tails and middle
+class StreamSummary {
+
+public:
+
+	StreamSummary(double low, double high, size_t bins) : Bins(low, high, bins) {}
+
+	void Push(double value)
+	{
+		Stats.Push(value);
+		P1.Push(value);
+		P50.Push(value);
+		P99.Push(value);
+		Bins.Push(value);
+	}
+
+	void Reset()
+	{
+		Stats.Reset();
+		P1.Reset();
+		P50.Reset();
+		P99.Reset();
+		Bins.Reset();
+	}
+
+	RunningStats Stats;
+
+	P2Quantile P1{ 0.01 };
+	P2Quantile P50{ 0.5 };
+	P2Quantile P99{ 0.99 };
+
+	Histogram Bins;
+};
@@ -0,0 +1,339 @@
+#pragma once
+
+// columnar telemetry history for the Data window plots, one shared double precision
+// time column and one typed column per signal, all in the same ring order
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "imgui/implot.h"
+
+#include "lod_pyramid.h"
+#include "sliding_window.h"
+
+// raw values for one sample, the derived VIN columns are filled in by the store
+struct TelemetryRow {
+	double Time;
+	int32_t Target;
+	int32_t Position;
+	float Velocity;
+	float Vin;
+};
+
+// one signal, raw values in the store's ring order plus a min/max pyramid for drawing long spans
+template <typename T>
+struct TelemetryColumn {
+	std::vector<T> Values;
+	MinMaxPyramid Lod;
+};
+
+class TelemetryStore {
+
+public:
+
+	// bytes a row costs once the store is full: the time, nine columns and their share of the
+	// pyramids, whose levels add up to about 1/(Fanout-1) of a bucket per row each. ~64 bytes
+	static constexpr size_t RowBytes = sizeof(double) + 2 * sizeof(int32_t) + 7 * sizeof(float)
+		+ 9 * sizeof(MinMaxPyramid::Bucket) / (MinMaxPyramid::Fanout - 1);
+
+	// ten minutes at 1kHz, ~38MB per TIC when full. an hour would be ~230MB each
+	static constexpr int DefaultCapacity = 10 * 60 * 1000;
+
+	// memory is only committed as it fills, and never past capacity rows
+	explicit TelemetryStore(int capacity = DefaultCapacity, int stats_window = 1500) :
+		StatsWindow(stats_window < capacity ? stats_window : capacity), VinStats(StatsWindow)
+	{
+		SetCapacity(capacity);
+	}
+
+	// erases everything and frees what was committed, then holds capacity rows
+	void SetCapacity(int capacity)
+	{
+		Erase();
+
+		// the stats window has to fit
+		Capacity = (capacity > StatsWindow) ? capacity : StatsWindow;
+
+		std::vector<double>().swap(Time);
+		Time.reserve(1024);
+
+		ForEachColumn([this](auto& column) {
+			decltype(column.Values)().swap(column.Values);
+			column.Values.reserve(1024);
+			column.Lod.Resize(Capacity);
+		});
+	}
+
+	int GetCapacity() const { return Capacity; }
+
+	void Add(const TelemetryRow& row)
+	{
+		// the oldest VIN in the stats window drops out first, it may be about to be overwritten
+		if (Count >= StatsWindow) {
+			VinStats.Evict(Vin.Values[Slot(Count - StatsWindow)]);
+		}
+
+		const bool grow = (Count < Capacity);
+		const int slot = grow ? Count : Offset;
+
+		if (grow) {
+
+			// doubling would overshoot capacity by up to half again
+			if (Time.size() == Time.capacity()) {
+				Reserve(Time.capacity() * 2 < (size_t)Capacity ? Time.capacity() * 2 : (size_t)Capacity);
+			}
+
+			Count++;
+			Time.push_back(row.Time);
+		}
+		else {
+			Offset = (Offset + 1) % Capacity;
+			Time[slot] = row.Time;
+		}
+
+		Set(Target, slot, grow, row.Target);
+		Set(Position, slot, grow, row.Position);
+		Set(Velocity, slot, grow, row.Velocity);
+		Set(Vin, slot, grow, row.Vin);
+
+		VinStats.Push(row.Vin);
+
+		if (++SinceResync >= StatsWindow) {
+			ResyncVin();
+		}
+
+		// VIN min/max since the store was last erased
+		if (Total == 0) {
+			VinLow = row.Vin;
+			VinHigh = row.Vin;
+		}
+
+		VinLow = (row.Vin < VinLow) ? row.Vin : VinLow;
+		VinHigh = (row.Vin > VinHigh) ? row.Vin : VinHigh;
+
+		Set(VinMin, slot, grow, (float)VinLow);
+		Set(VinMax, slot, grow, (float)VinHigh);
+
+		Set(VinAvgPct, slot, grow, (float)((VinStats.Avg() / row.Vin) * 100.0));
+		Set(VinMinPct, slot, grow, (float)((VinStats.Min() / row.Vin) * 100.0));
+		Set(VinMaxPct, slot, grow, (float)((VinStats.Max() / row.Vin) * 100.0));
+
+		Total++;
+	}
+
+	void Erase()
+	{
+		Count = 0;
+		Offset = 0;
+		Total = 0;
+		SinceResync = 0;
+
+		Time.clear();
+
+		ForEachColumn([](auto& column) {
+			column.Values.clear();
+			column.Lod.Clear();
+		});
+
+		VinStats.Reset();
+	}
+
+	int Size() const { return Count; }
+
+	// logical index 0 is the oldest sample
+	int Slot(int idx) const { return (Offset + idx) % Capacity; }
+
+	double LatestTime() const { return Count ? Time[Slot(Count - 1)] : 0; }
+
+	// first logical index with time >= t
+	int LowerBound(double t) const
+	{
+		int lo = 0, hi = Count;
+
+		while (lo < hi) {
+			const int mid = lo + (hi - lo) / 2;
+
+			if (Time[Slot(mid)] < t) {
+				lo = mid + 1;
+			}
+			else {
+				hi = mid;
+			}
+		}
+
+		return lo;
+	}
+
+	// line plot of one column against the shared time column, call between BeginPlot/EndPlot.
+	// only the visible range is drawn, decimated through the column's pyramid so a long
+	// history costs about two points per pixel
+	template <typename T>
+	void PlotLine(const char* label, const TelemetryColumn<T>& column) const
+	{
+		if (Count == 0) {
+			return;
+		}
+
+		const ImPlotLimits limits = ImPlot::GetPlotLimits();
+		const float width = ImPlot::GetPlotSize().x;
+
+		// one either side so the line runs off the edges
+		int first = LowerBound(limits.X.Min) - 1;
+		int last = LowerBound(limits.X.Max) + 1;
+
+		first = (first < 0) ? 0 : first;
+		last = (last > Count) ? Count : last;
+
+		if (last <= first) {
+			return;
+		}
+
+		const int level = column.Lod.PickLevel((uint64_t)(last - first), (uint64_t)(width > 1 ? width : 1));
+
+		if (level == 0) {
+			ColumnView<T> view = { this, column.Values.data(), first };
+
+			ImPlot::PlotLineG(label, &ColumnView<T>::Get, &view, last - first);
+			return;
+		}
+
+		const uint64_t oldest = Total - Count;
+		const uint64_t absFirst = oldest + first;
+		const uint64_t absLast = oldest + last - 1;
+		const int shift = level * MinMaxPyramid::FanoutBits;
+
+		Scratch.clear();
+
+		for (uint64_t id = absFirst >> shift; id <= (absLast >> shift); id++) {
+
+			const uint64_t start = id << shift;
+
+			// partly overwritten already, its min/max may point at samples we no longer hold
+			if (start < oldest) {
+				continue;
+			}
+
+			const MinMaxPyramid::Bucket& bucket = column.Lod.Get(level, id);
+
+			const ImPlotPoint low(Time[Slot((int)(start + bucket.MinAt - oldest))], bucket.Min);
+			const ImPlotPoint high(Time[Slot((int)(start + bucket.MaxAt - oldest))], bucket.Max);
+
+			if (bucket.MinAt <= bucket.MaxAt) {
+				Scratch.push_back(low);
+				Scratch.push_back(high);
+			}
+			else {
+				Scratch.push_back(high);
+				Scratch.push_back(low);
+			}
+		}
+
+		if (Scratch.size()) {
+			ImPlot::PlotLineG(label, &ScratchGet, (void*)&Scratch, (int)Scratch.size());
+		}
+	}
+
+	const int StatsWindow;
+
+	std::vector<double> Time;
+
+	TelemetryColumn<int32_t> Target;
+	TelemetryColumn<int32_t> Position;
+	TelemetryColumn<float> Velocity;
+
+	TelemetryColumn<float> Vin;
+	TelemetryColumn<float> VinMin;
+	TelemetryColumn<float> VinMax;
+	TelemetryColumn<float> VinAvgPct;
+	TelemetryColumn<float> VinMinPct;
+	TelemetryColumn<float> VinMaxPct;
+
+	// average, min and max of VIN over the last StatsWindow samples
+	SlidingStats VinStats;
+
+private:
+
+	template <typename T>
+	struct ColumnView {
+
+		const TelemetryStore* Store;
+		const T* Values;
+		int First;
+
+		static ImPlotPoint Get(void* data, int idx)
+		{
+			const ColumnView* view = (const ColumnView*)data;
+			const int slot = view->Store->Slot(view->First + idx);
+
+			return ImPlotPoint(view->Store->Time[slot], (double)view->Values[slot]);
+		}
+	};
+
+	static ImPlotPoint ScratchGet(void* data, int idx)
+	{
+		return (*(const std::vector<ImPlotPoint>*)data)[idx];
+	}
+
+	template <typename F>
+	void ForEachColumn(F f)
+	{
+		f(Target);
+		f(Position);
+		f(Velocity);
+		f(Vin);
+		f(VinMin);
+		f(VinMax);
+		f(VinAvgPct);
+		f(VinMinPct);
+		f(VinMaxPct);
+	}
+
+	void Reserve(size_t rows)
+	{
+		Time.reserve(rows);
+
+		ForEachColumn([rows](auto& column) {
+			column.Values.reserve(rows);
+		});
+	}
+
+	template <typename T>
+	void Set(TelemetryColumn<T>& column, int slot, bool grow, T value)
+	{
+		if (grow) {
+			column.Values.push_back(value);
+		}
+		else {
+			column.Values[slot] = value;
+		}
+
+		column.Lod.Push(Total, (float)value);
+	}
+
+	void ResyncVin()
+	{
+		const int n = (Count < StatsWindow) ? Count : StatsWindow;
+		double sum = 0;
+
+		for (int i = Count - n; i < Count; i++) {
+			sum += Vin.Values[Slot(i)];
+		}
+
+		VinStats.SetSum(sum);
+		SinceResync = 0;
+	}
+
+	int Capacity = 0;
+	int Count = 0;
+	int Offset = 0;
+	int SinceResync = 0;
+
+	// samples added since the last Erase(), the pyramid indexes by this
+	uint64_t Total = 0;
+
+	double VinLow = 0, VinHigh = 0;
+
+	// decimated points for the plot being drawn
+	mutable std::vector<ImPlotPoint> Scratch;
+};
@@ -1,8 +1,13 @@
 #pragma once
 
+// the CMake build defines these on the command line too
+#ifndef TIC_STATIC
 #define TIC_STATIC
+#endif
 #define DEPRECATED
+#ifndef LIBUSBP_STATIC
 #define LIBUSBP_STATIC (1)
+#endif
 
 #define SOFTWARE_VERSION_STRING "1.07"
 #define SOFTWARE_VERSION_MAJOR 1
@@ -10,27 +10,46 @@
 #include <cmath>
 
 #include <iostream>
+#include <cstdlib>
+#include <ctime>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+
 #include <math.h>
+
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 #include "tic/tic.hpp"
 #include "imgui/imgui.h"
-#include "imgui/imgui_impl_win32.h"
-#include "imgui/imgui_impl_dx12.h"
 
 #include "imgui/implot.h"
 
+#include "render_scheduler.h"
+#include "replay.h"
+#include "settings_diff.h"
+#include "settings_library.h"
+#include "sim_tic.h"
+#include "telemetry.h"
+#include "tic_context.h"
+#include "trainer.h"
+#include "trajectory.h"
+#include "tuner.h"
+
 #ifndef M_PI
 #   define M_PI    3.14159265358979323846
 #endif
 
+// the CMake build compiles libtic and libusbp from source instead
+#ifdef _MSC_VER
 #pragma comment(lib,"tic/libtic.lib")
 #pragma comment(lib,"tic/usbp-1.lib")
 
 #pragma comment(lib,"setupapi.lib")
 #pragma comment(lib,"winusb.lib")
+#endif
 
 
 // step mode, @todo pull from tic library
@@ -49,17 +68,6 @@ static constexpr char stepModes[][20] = {
 	"1/256 step"
 };
 
-// movement modes for slider
-enum class Modes {
-	mNONE,
-	mSIN,
-	mSIN2,
-	mSIN3,
-	mPINGPONG,
-};
-
-Modes mMode;
-
 // T825 decay modes @tood check with TIC lib
 static constexpr char decayModes[][20] = {
 	"slow",
@@ -73,110 +81,148 @@ bool bBorderless = false;
 // switch on vSync
 bool bVSync = true;
 
-// TIC library
-static tic::handle handle;
-static tic::variables vars;
-static tic::settings settings;
+// headless builds quit after this many seconds, 0 runs until signalled
+double dRunFor = 0;
+
+// when the render loops draw, idle unless something is moving
+RenderScheduler renderScheduler;
+
+// one per TIC being driven, real ones over USB or simulated
+static std::vector<std::unique_ptr<TicContext>> contexts;
+
+// the TIC the GUI is showing, picked by the tabs in Motor Controls
+static TicContext* selected = nullptr;
+
+// recording opened for scrubbing through in the Data window
+static Replay replay;
+
+// coordinated moves across every TIC ticked for one
+static TrajectoryScheduler sync;
+
+// sweeps one TIC's speed, accel, current and step mode for the fastest stable settings
+static SweepTuner tuner;
+
+// phases of idle, energised and moving VIN on one TIC, timed on its own thread
+static Trainer trainer;
 
-// invert motor direction
-static bool bInvertMotor = false;
+// named tuning sets on disk, indexed in memory so switching one in is a diff against the TIC
+static SettingsLibrary tuningSets;
+
+// rate profiles are worked out at for the acquisition threads to step through
+static constexpr double ProfileRate = 1000.0;
+
+// default poll rate for the acquisition threads
+static int iPollRate			= 1000;
+
+// acquisition threads drop to Acquisition::IdleRateHz while their TIC is still and nothing's recording
+static bool bIdlePoll = false;
+
+// minutes of telemetry each TIC keeps for the plots, at the poll rate when it was set
+static int iHistoryMinutes		= TelemetryStore::DefaultCapacity / (60 * 1000);
 
 // save changes to TICs onboard flash
 static bool bAutoUpdate = false;
 
-// flags if any settings were changed
-static bool bChanged = false;
+// runtime settings go to the TIC as volatile commands on the next poll as the sliders move.
+// it takes the change before auto update would see it, so only one of the two is on at a time
+static bool bLiveTune = false;
 
 // use one value to set accel and deaccel
 static bool bOneAccel = true;
 
-// settings for stepper motor
-static int iMaxSpeed			= 28400000;
-static int iStartingSpeed		= 0;
-static int iMaxAcceleration		= 280000;
-static int iMaxDeceleration		= 280000;
-static int step_mode			= 0;
-static int decay_mode			= 0;
-static int current_limit		= 0;
-
 // function for ImGui setup
 int RenderGUI();
 bool SetupImgui();
 void  RenderLoop();
+
+// the render loop draws now rather than at its idle rate, safe from any thread
+void WakeRenderLoop();
 bool CleanupImgui();
 
-// utility structure for realtime plot + average, min and max tracking across buffer
-struct ScrollingBuffer {
+// energise/deenergise from the GUI thread, posted to the acquisition thread so the
+// frame never waits on a USB transfer. errors show up in Acq.GetLastError()
+static void EnergiseTIC(TicContext& context)
+{
+	context.Acq.Post([](TicDevice& device) { device.energize(); });
+	context.bEnabled = true;
+}
 
-	int MaxSize;
-	int Offset;
+static void DeenergiseTIC(TicContext& context)
+{
+	context.Acq.Post([](TicDevice& device) { device.deenergize(); });
+	context.bEnabled = false;
+}
 
-	ImVector<ImVec2> Data;
-	ImVec2 DataAvg;
+// pull the slider values out of the settings read from the TIC
+static void LoadSettings(TicContext& context)
+{
+	const tic_settings* s = context.Settings.get_pointer();
 
-	double min = DBL_MAX, max = DBL_MIN;
+	context.step_mode = tic_settings_get_step_mode(s);
+	context.decay_mode = tic_settings_get_decay_mode(s);
+	context.current_limit = tic_settings_get_current_limit(s);
 
-	ScrollingBuffer(int max_size = 1500) {
-		MaxSize = max_size;
-		Offset = 0;
+	context.bInvertMotor = tic_settings_get_input_invert(s);
 
-		Data.reserve(MaxSize);
+	context.iMaxSpeed = tic_settings_get_max_speed(s);
+	context.iStartingSpeed = tic_settings_get_starting_speed(s);
+	context.iMaxAcceleration = tic_settings_get_max_accel(s);
+	context.iMaxDeceleration = tic_settings_get_max_decel(s);
+}
 
-		DataAvg.x = 0;
-		DataAvg.y = 0;
-	}
+// tic lib needs this on windows, everywhere else it comes from libc
 
-	void AddPoint(float x, float y) {
-		if (Data.size() < MaxSize) {
-			Data.push_back(ImVec2(x, y));
-		}
-		else {
-			Data[Offset] = ImVec2(x, y);
-			Offset = (Offset + 1) % MaxSize;
-		}
+#ifdef _WIN32
+extern "C" void usleep(__int64 usec)
+{
+	// one timer per calling thread, created on first use rather than per call
+	static thread_local HANDLE timer = CreateWaitableTimer(NULL, TRUE, NULL);
 
-		DataAvg.x = 0;
-		DataAvg.y = 0;
+	LARGE_INTEGER ft;
 
-		min = DBL_MAX;
-		max = DBL_MIN;
+	ft.QuadPart = -(10 * usec);										// Convert to 100 nanosecond interval, negative value indicates relative time
 
-		for (int i = 0; i < Data.size(); i++) {
-			DataAvg.x += Data[i].x;
-			DataAvg.y += Data[i].y;
+	if (timer) {
+		SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
+		WaitForSingleObject(timer, INFINITE);
+	}
+}
+#endif
 
-			min = min(Data[i].y, min);
-			max = max(Data[i].y, max);
-		}
+// timestamped log name in the working directory, one per TIC
+static std::string RecordingName(const TicContext& context, const char* extension = ".tlog")
+{
+	char name[64];
 
-		DataAvg.x /= Data.size();
-		DataAvg.y /= Data.size();
-	}
+	const std::time_t now = std::time(nullptr);
+	std::strftime(name, sizeof(name), "ticTune-%Y%m%d-%H%M%S", std::localtime(&now));
+
+	std::string serial = context.Device->get_name();
 
-	void Erase() {
-		if (Data.size() > 0) {
-			Data.shrink(0);
-			Offset = 0;
+	for (char& c : serial) {
+		if (c == ' ' || c == '/' || c == '\\') {
+			c = '_';
 		}
 	}
-};
 
-// tic lib needs this
+	return std::string(name) + "-" + serial + extension;
+}
 
-extern "C" void usleep(__int64 usec)
+// --record FILE with several TICs puts the index before the extension
+static std::string IndexedPath(const std::string& path, size_t index, size_t count)
 {
-	HANDLE timer;
-	LARGE_INTEGER ft;
-
-	ft.QuadPart = -(10 * usec);										// Convert to 100 nanosecond interval, negative value indicates relative time
+	if (count < 2) {
+		return path;
+	}
 
-	timer = CreateWaitableTimer(NULL, TRUE, NULL);
+	const size_t dot = path.find_last_of('.');
+	const size_t slash = path.find_last_of("/\\");
 
-	if (timer) {
-		SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
-		WaitForSingleObject(timer, INFINITE);
-		CloseHandle(timer);
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+		return path + "-" + std::to_string(index);
 	}
+
+	return path.substr(0, dot) + "-" + std::to_string(index) + path.substr(dot);
 }
 
 // moved this out of the function so we can use it in the GUI as a picker @todo
@@ -185,94 +231,158 @@ static std::vector<tic::device> list;
 // Opens a handle to a Tic that can be used for communication.
 //
 // To open a handle to any Tic:
-//   tic_handle * handle = open_handle();
+//   auto device = open_device();
 // To open a handle to the Tic with serial number 01234567:
-//   tic_handle * handle = open_handle("01234567");
-tic::handle open_handle(const char* desired_serial_number = nullptr)
+//   auto device = open_device("01234567");
+std::unique_ptr<TicDevice> open_device(const char* desired_serial_number = nullptr)
 {
 	// Get a list of Tic devices connected via USB.
 	// moved to init
 
 	// Iterate through the list and select one device.
-	for (const tic::device& device : list) {
+	for (const tic::device& candidate : list) {
 		if (desired_serial_number &&
-			device.get_serial_number() != desired_serial_number) {
+			candidate.get_serial_number() != desired_serial_number) {
 			// Found a device with the wrong serial number, so continue on to
 			// the next device in the list.
 			continue;
 		}
 
 		// Open a handle to this device and return it.
-		return tic::handle(device);
+		return std::make_unique<UsbTicDevice>(candidate);
 	}
 
 	throw std::runtime_error("No device found.");
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	// --sim runs against the simulated TIC, --sim-speed N runs it N times faster than real time,
+	// --run-for N stops the headless build after N seconds, --record FILE logs every sample from startup,
+	// --sim-count N simulates N TICs. with real TICs every one connected is opened
+	bool bSimulate = false;
+	double simSpeed = 1.0;
+	int simCount = 1;
+	std::string recordPath;
+
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+
+		if (arg == "--sim") {
+			bSimulate = true;
+		}
+		else if (arg == "--sim-speed" && i + 1 < argc) {
+			bSimulate = true;
+			simSpeed = atof(argv[++i]);
+		}
+		else if (arg == "--sim-count" && i + 1 < argc) {
+			bSimulate = true;
+			simCount = atoi(argv[++i]);
+		}
+		else if (arg == "--run-for" && i + 1 < argc) {
+			dRunFor = atof(argv[++i]);
+		}
+		else if (arg == "--record" && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+
+	}
 
 	//build list of TIC connected
-	list = tic::list_connected_devices();
+	if (!bSimulate) {
+		list = tic::list_connected_devices();
+	}
 
 	SetupImgui();
 
-	// Handle the TIC
+	// Handle the TICs
 	try {
 
-		handle = open_handle();
-
-		vars = handle.get_variables();
-		settings = handle.get_settings();
-
-		step_mode =
-			tic_settings_get_step_mode(settings.get_pointer());
-
-		decay_mode =
-			tic_settings_get_decay_mode(settings.get_pointer());
-
-		current_limit =
-			tic_settings_get_current_limit(settings.get_pointer());
+		if (bSimulate) {
+			for (int i = 0; i < (simCount > 0 ? simCount : 1); i++) {
+				auto sim = std::make_unique<SimTicDevice>();
+				sim->SetTimeScale(simSpeed);
+				contexts.push_back(std::make_unique<TicContext>(std::move(sim)));
+			}
+		}
+		else {
+			for (const tic::device& candidate : list) {
+				contexts.push_back(std::make_unique<TicContext>(open_device(candidate.get_serial_number().c_str())));
+			}
 
-		bInvertMotor = tic_settings_get_input_invert(settings.get_pointer());
+			if (contexts.empty()) {
+				throw std::runtime_error("No device found.");
+			}
+		}
 
-		iMaxSpeed = tic_settings_get_max_speed(settings.get_pointer());
-		iStartingSpeed = tic_settings_get_starting_speed(settings.get_pointer());
-		iMaxAcceleration = tic_settings_get_max_accel(settings.get_pointer());
-		iMaxDeceleration = tic_settings_get_max_decel(settings.get_pointer());
+		for (auto& context : contexts) {
+			context->Settings = context->Device->get_settings();
+			context->Stored = context->Settings;
+			LoadSettings(*context);
+		}
 	}
 	catch (const std::exception& error) {
 		std::cerr << "Error: " << error.what() << std::endl;
 		return 1;
 	}
 
-	// turn TIC off
-	handle.deenergize();
+	if (!tuningSets.Open("tuning")) {
+		std::cerr << "Error: " << tuningSets.GetError() << std::endl;
+	}
+
+	// one time base for every TIC, so their telemetry and recordings line up. simulators
+	// share a clock, so the first one's now does for all of them
+	const std::chrono::steady_clock::time_point epoch = contexts.front()->Device->Now();
+
+	for (size_t i = 0; i < contexts.size(); i++) {
+
+		TicContext& context = *contexts[i];
+
+		// turn TIC off
+		context.Device->deenergize();
+
+		if (!recordPath.empty()) {
+			context.Rec.Open(IndexedPath(recordPath, i, contexts.size()));
+		}
+
+		context.Acq.SetRecorder(&context.Rec);
+		context.Acq.SetNotify(&WakeRenderLoop);
+		context.Acq.Start(*context.Device, iPollRate, epoch);
+	}
+
+	selected = contexts.front().get();
 
 	RenderLoop();
 
+	trainer.Stop();
+	tuner.Stop();
+	sync.Stop();
+
+	for (auto& context : contexts) {
+		context->Acq.Stop();
+		context->Rec.Close();
+	}
+
 	CleanupImgui();
 
+	contexts.clear();
+
 	return 0;
 }
-extern int main();
 
+#ifdef _WIN32
 // console vs windows subsystem
 int __stdcall WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow)
 {
-	main();
+	return main(__argc, __argv);
 }
+#endif
+
 
 // scale the ranges for the step mode selected
 int GetRange(int step_mode, const int base = UPPER_RANGE)
 {
-	const int scaler[6] = { 1,2,4,8,16,32 };
-
-	if (step_mode < 6 ) {
-		return (base * scaler[step_mode]);
-	} else {
-		return base;
-	}
+	return base * (int)Microsteps((uint8_t)step_mode);
 }
 
 
@@ -343,18 +453,18 @@ bool DrawSlider(const std::string name, int& variable, int lower, int upper)
 	return (ret ? true : false);
 }
 
-bool DrawButton(const char* const label, Modes mode, bool bSameLine = true)
+bool DrawButton(const char* const label, int& current, int mode, bool bSameLine = true)
 {
 	bool ret = false;
 	bool bStylePushed = false;
 
-	if (mMode != mode) {
+	if (current != mode) {
 		ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
 		bStylePushed = true;
 	}
 
 	if (ImGui::Button(label)) {
-		mMode = mode;
+		current = mode;
 		ret = true;
 	}
 
@@ -369,507 +479,988 @@ bool DrawButton(const char* const label, Modes mode, bool bSameLine = true)
 	return ret;
 }
 
+// a profile from ProfileLibrary() worked out onto the TIC's range for its step mode
+static SetpointTable BuildProfileTable(const TicContext& context, int profile, double rateHz)
+{
+	return BuildTable(*ProfileLibrary()[profile].Make(), rateHz, GetRange(context.step_mode), GetRange(context.step_mode, LOWER_RANGE));
+}
+
+// setpoints for one axis of a synchronised move, one per tick at rateHz
+static std::vector<int32_t> BuildSetpoints(const TicContext& context, int profile, double duration, double rateHz)
+{
+	const SetpointTable table = BuildProfileTable(context, profile, rateHz);
+
+	std::vector<int32_t> setpoints((size_t)(duration * rateHz) + 1);
+
+	for (size_t i = 0; i < setpoints.size(); i++) {
+		setpoints[i] = table.At(i / rateHz);
+	}
+
+	return setpoints;
+}
+
+// start a profile from ProfileLibrary() on the acquisition thread, -1 stops it
+static void ApplyProfile(TicContext& context, int profile)
+{
+	context.Profile = profile;
+
+	if (profile < 0) {
+		context.Acq.SetTable(nullptr);
+		return;
+	}
+
+	SetpointTable table = BuildProfileTable(context, profile, ProfileRate);
+
+	table.bVelocity = context.bVelocityControl;
+
+	context.Acq.SetTable(std::make_shared<const SetpointTable>(std::move(table)));
+}
+
+// switch context to a tuning set from tuningSets. only the runtime fields go to the TIC, as
+// volatile commands, the rest of the set waits in the sliders for Commit to Flash so a load
+// writes nothing to the TIC's EEPROM. false if it's for another product
+static bool LoadTuningSet(TicContext& context, const tic::settings& settings)
+{
+	if (settings.get_product() != context.Stored.get_product()) {
+		return false;
+	}
+
+	context.Settings = settings;
+	context.bChanged = false;
+	context.bRefreshing = false;
+
+	LoadSettings(context);
+
+	// the profile's table was mapped onto the old step mode's range
+	if (context.Profile >= 0) {
+		ApplyProfile(context, context.Profile);
+	}
+
+	context.Acq.Post([settings](TicDevice& device) {
+		SendRuntimeSettings(device, settings);
+	});
+
+	return true;
+}
+
+// one row per polled sample, timed by the acquisition clock so the plots hold every
+// sample whatever the frame rate
+static void AddTelemetry(TicContext& context, const TicSample& sample)
+{
+	TelemetryRow row;
+
+	row.Time = sample.Time;
+	row.Target = sample.RequestPosition;
+	row.Position = sample.CurrentPosition;
+	row.Velocity = (float)(sample.CurrentVelocity / 10000) - (sample.MaxSpeed / 10000.0f);
+	row.Vin = (float)(sample.VinVoltage / 1000.0);
+
+	context.Telemetry.Add(row);
+}
+
+// drain what the acquisition thread polled since last frame and hand it the slider's target
+static void UpdateDevice(TicContext& context)
+{
+	// keep the newest, telemetry and tracking see them all
+	while (context.Acq.PopSample(context.Sample)) {
+
+		AddTelemetry(context, context.Sample);
+
+		context.Tracking.Add(context.Sample.Time, context.Sample.RequestPosition, context.Sample.CurrentPosition);
+	}
+
+	// stored settings after an Update or Refresh, a refresh shows them unless the sliders moved meanwhile
+	if (context.SettingsReply.valid() && context.SettingsReply.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		try {
+			context.Stored = context.SettingsReply.get();
+
+			if (context.bRefreshing && !context.bChanged) {
+				context.Settings = context.Stored;
+			}
+		}
+		catch (const std::exception&) {
+			// already in Acq.GetLastError()
+		}
+
+		context.bRefreshing = false;
+	}
+
+	// the trainer switches the motor on and off from its own thread
+	if (trainer.IsTraining(context)) {
+		context.bEnabled = trainer.IsEnergised();
+	}
+
+	// the tuner searches on its own thread too, the sliders take what it found once it's done
+	tuner.Collect(context);
+
+	// a profile or the scheduler is driving this one
+	if (context.Acq.HasTable() || sync.IsDriving(&context.Acq)) {
+		context.Target = context.Acq.GetTarget();
+		return;
+	}
+
+	// the acquisition thread handles exit_safe_start and chasing the target
+	context.Acq.SetTarget(context.Target);
+}
+
 int RenderGUI()
 {
 	static bool _showMTTuning = true;
-	static bool _bEnableTIC = false;
-	static float elapsedTime = 0;
+	static double elapsedTime = 0;
 
 	static bool bPaused = false;
 
-	ImVec2 winSize;
-	static ScrollingBuffer positionHistory[3];
-	static ScrollingBuffer vinHistory[6];   // vin, min, max
+	// every TIC keeps moving and collecting, whichever one the GUI is showing
+	// plots only need the display rate while something is moving or being driven
+	bool bLive = sync.IsRunning() || tuner.IsRunning() || trainer.IsRunning();
 
-	ImGui::SetNextWindowSize(ImVec2(1000, 640), ImGuiCond_FirstUseEver);
+	for (auto& context : contexts) {
 
-	static int32_t new_target = 0;
+		UpdateDevice(*context);
 
-	ImGui::Begin("Motor Controls##ticTune", &_showMTTuning);
-	{
-		if (ImGui::Button("ENERGISE")) {
-			handle.energize();
-			_bEnableTIC = true;
-		}
+		const TicSample& sample = context->Sample;
 
-		ImGui::SameLine();
+		// away from its target only counts if it's able to get there, a de-energised or
+		// faulted TIC sits still however far off it is
+		const bool bRunning = sample.OperationState == TIC_OPERATION_STATE_NORMAL && sample.ErrorStatus == 0;
 
-		if (ImGui::Button("DEENERGISE")) {
-			_bEnableTIC = false;
-			handle.deenergize();
+		if (context->Acq.HasTable() || sample.CurrentVelocity != 0 || (bRunning && sample.CurrentPosition != context->Target)) {
+			bLive = true;
 		}
+	}
 
-		if (_bEnableTIC) {
-			ImGui::SameLine();
-			ImGui::Text("Enabled");
-		}
+	renderScheduler.SetLive(bLive && !bPaused);
 
-		for (const tic::device& device : list) {
-			ImGui::Text("%s %lu", 
-				device.get_short_name().c_str(), 
-				device.get_serial_number() 
-			);
+	// the plots follow the newest sample, pausing holds the view while telemetry carries on
+	if (!bPaused) {
+		for (auto& context : contexts) {
+			if (context->Sample.Time > elapsedTime) {
+				elapsedTime = context->Sample.Time;
+			}
 		}
+	}
+
+	ImGui::SetNextWindowSize(ImVec2(1000, 640), ImGuiCond_FirstUseEver);
 
+	ImGui::Begin("Motor Controls##ticTune", &_showMTTuning);
+	{
 		ImGui::Checkbox("Pause", &bPaused);
 		ImGui::SameLine();
 		ImGui::Checkbox("AA", &ImPlot::GetStyle().AntiAliasedLines);
 		ImGui::SameLine();
 		ImGui::Checkbox("vSync", &bVSync);
-		ImGui::NewLine();
+		ImGui::SameLine();
 
-		DrawButton("NONE", Modes::mNONE);
-		DrawButton("SIN", Modes::mSIN);
-		DrawButton("SIN 2x", Modes::mSIN2);
-		DrawButton("SIN 3", Modes::mSIN3);
-		DrawButton("PING PONG", Modes::mPINGPONG, false);
+		int idleRate = (int)renderScheduler.GetIdleRate();
 
-		try {
-			bool bUpdate = false;
+		ImGui::SetNextItemWidth(100);
 
-			// this would override what we have
-			// settings = handle.get_settings();
+		if (ImGui::SliderInt("Idle Hz##idleRate", &idleRate, 1, 60)) {
+			renderScheduler.SetIdleRate(idleRate);
+		}
 
-			vars = handle.get_variables();
+		ImGui::SameLine();
+		ImGui::Text(renderScheduler.IsLive() ? "live" : "idle");
 
-			int32_t current_position = vars.get_current_position();
+		if (ImGui::SliderInt("Poll Rate (Hz)##pollRate", &iPollRate, 10, 2000)) {
+			for (auto& context : contexts) {
+				context->Acq.SetRate(iPollRate);
+			}
+		}
 
-			static double request = 0;
+		ImGui::SameLine();
 
-			if (mMode == Modes::mSIN) {
-				request = sin(elapsedTime);
-				bUpdate = true;
+		if (ImGui::Checkbox("Slow Poll When Idle##idlePoll", &bIdlePoll)) {
+			for (auto& context : contexts) {
+				context->Acq.SetIdlePoll(bIdlePoll);
 			}
+		}
 
-			if (mMode == Modes::mSIN2) {
-				request = ((sin(elapsedTime * 2.0)));
-				bUpdate = true;
+		// resizing erases the history, so only once the slider's let go
+		ImGui::SliderInt("History (min)##history", &iHistoryMinutes, 1, 60);
+
+		if (ImGui::IsItemDeactivatedAfterEdit()) {
+			for (auto& context : contexts) {
+				context->Telemetry.SetCapacity(iHistoryMinutes * 60 * iPollRate);
 			}
+		}
 
-			//sin(2 * pi * x) + cos(x / 2 * pi)
+		ImGui::SameLine();
+		ImGui::Text("%.0f MB per TIC", (double)iHistoryMinutes * 60 * iPollRate * TelemetryStore::RowBytes / (1024.0 * 1024.0));
 
-			if (mMode == Modes::mSIN3) {
+		if (ImGui::BeginTabBar("Devices##devices")) {
 
-				request = ((sin(2.0 * M_PI * elapsedTime) + cos(elapsedTime / 2.0 * M_PI)) / 2.0);
-				bUpdate = true;
-			}
+			for (size_t i = 0; i < contexts.size(); i++) {
 
-			static float lastChange = 1;
+				TicContext& context = *contexts[i];
 
-			if (mMode == Modes::mPINGPONG) {
+				const std::string label = context.Device->get_name() + "##device" + std::to_string(i);
 
-				if (elapsedTime > lastChange) {
+				if (!ImGui::BeginTabItem(label.c_str())) {
+					continue;
+				}
 
-					if (request == 1) {
+				selected = &context;
 
-						request = -1;
+				try {
+					if (ImGui::Button("ENERGISE")) {
+						EnergiseTIC(context);
 					}
-					else {
-						request = 1;
+
+					ImGui::SameLine();
+
+					if (ImGui::Button("DEENERGISE")) {
+						DeenergiseTIC(context);
+					}
+				}
+				catch (const std::exception& error) {
+					std::cerr << "Error: " << error.what() << std::endl;
+				}
+
+				if (context.bEnabled) {
+					ImGui::SameLine();
+					ImGui::Text("Enabled");
+				}
+
+				if (!context.Rec.IsOpen()) {
+					if (ImGui::Button("Record")) {
+						context.Rec.Open(RecordingName(context));
 					}
+				}
+				else {
+					if (ImGui::Button("Stop Recording")) {
+						context.Rec.Close();
+					}
+
+					ImGui::SameLine();
+					ImGui::Text("%s", context.Rec.GetPath().c_str());
+				}
+
+				const std::vector<ProfileEntry>& library = ProfileLibrary();
+
+				// follow the profile with set_target_velocity instead of chasing positions
+				if (ImGui::Checkbox("Velocity Control", &context.bVelocityControl) && context.Profile >= 0) {
+					ApplyProfile(context, context.Profile);
+				}
 
-					lastChange = elapsedTime + 1;
+				int profile = context.Profile;
+
+				if (DrawButton("NONE", profile, -1)) {
+					ApplyProfile(context, -1);
+				}
+
+				for (size_t p = 0; p < library.size(); p++) {
+					if (DrawButton(library[p].Name, profile, (int)p, p + 1 < library.size())) {
+						ApplyProfile(context, (int)p);
+					}
 				}
 
-				bUpdate = true;
+				ImGui::EndTabItem();
 			}
 
-			ImGui::End();
+			ImGui::EndTabBar();
+		}
+
+		if (ImGui::CollapsingHeader("Synchronised Move")) {
+
+			static int syncProfile = 0;
+			static float syncDuration = 10.0f;
+			static int syncRate = 200;
 
-			if (bUpdate) {
+			ImGui::BeginDisabled(sync.IsRunning());
 
-				double temp = (((double)request + 1.0) / 2.0) * ( ( GetRange(step_mode,LOWER_RANGE) - GetRange(step_mode) ) ) + GetRange(step_mode);
+			for (size_t i = 0; i < contexts.size(); i++) {
 
-				new_target = (int32_t)temp;
+				const std::string label = contexts[i]->Device->get_name() + "##sync" + std::to_string(i);
 
-				handle.set_target_position(new_target);
+				ImGui::Checkbox(label.c_str(), &contexts[i]->bSync);
+
+				if (i + 1 < contexts.size()) {
+					ImGui::SameLine();
+				}
 			}
 
-			if ( !bPaused ) {
+			const std::vector<ProfileEntry>& library = ProfileLibrary();
+
+			for (size_t p = 0; p < library.size(); p++) {
+				const std::string label = std::string(library[p].Name) + "##sync";
+
+				DrawButton(label.c_str(), syncProfile, (int)p, p + 1 < library.size());
+			}
+
+			ImGui::SliderFloat("Duration (s)##syncDuration", &syncDuration, 1.0f, 120.0f);
+			ImGui::SliderInt("Setpoint Rate (Hz)##syncRate", &syncRate, 10, (int)TrajectoryScheduler::MaxRateHz);
+
+			ImGui::EndDisabled();
+
+			if (!sync.IsRunning()) {
+				if (ImGui::Button("Start##sync")) {
+
+					std::vector<TrajectoryScheduler::Axis> axes;
+
+					for (auto& context : contexts) {
+
+						// a TIC being tuned or trained stays with that, they'd overwrite each other's targets
+						if (!context->bSync || tuner.IsTuning(*context) || trainer.IsTraining(*context)) {
+							continue;
+						}
+
+						// the scheduler takes over from any profile it was running
+						ApplyProfile(*context, -1);
+
+						TrajectoryScheduler::Axis axis;
+
+						axis.Device = context->Device.get();
+						axis.Acq = &context->Acq;
+						axis.Setpoints = BuildSetpoints(*context, syncProfile, syncDuration, syncRate);
 
-				elapsedTime += ImGui::GetIO().DeltaTime;
+						axes.push_back(std::move(axis));
+					}
+
+					sync.Start(std::move(axes), syncRate);
+				}
+			}
+			else {
+				if (ImGui::Button("Stop##sync")) {
+					sync.Stop();
+				}
+			}
+
+			ImGui::SameLine();
+			ImGui::ProgressBar((float)sync.GetProgress());
 
-				positionHistory[0].AddPoint(elapsedTime, (float)new_target);
+			const TrajectoryScheduler::Skew skew = sync.GetSkew();
 
-				positionHistory[1].AddPoint(elapsedTime, (float)current_position);
+			ImGui::Text("Skew  last %.3fms  mean %.3fms  max %.3fms", skew.Last * 1000.0, skew.Mean * 1000.0, skew.Max * 1000.0);
+			ImGui::Text("Ticks %llu  late %llu", (unsigned long long)skew.Ticks, (unsigned long long)skew.Late);
 
-				positionHistory[2].AddPoint(elapsedTime, (float)(vars.get_current_velocity() / 10000) - (vars.get_max_speed() / 10000.0f));
+			const std::string error = sync.GetLastError();
 
+			if (!error.empty()) {
+				ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", error.c_str());
 			}
+		}
+	}
+	ImGui::End();
+
+	TicContext& current = *selected;
+	const TicSample& sample = current.Sample;
+
+	{
+		double vin = (sample.VinVoltage / 1000.0);
 
-			double vin = (vars.get_vin_voltage() / 1000.0);
+		const double vinAvg = current.Telemetry.VinStats.Avg();
+		const double vinLow = current.Telemetry.VinStats.Min();
+		const double vinHigh = current.Telemetry.VinStats.Max();
 
-			static double vinMin;
-			static double vinMax;
+		if (ImGui::Begin("Information")) {
 
-			if (vinHistory[0].Data.size() == 0) {
+			static bool showWarning = sizeof(ImDrawIdx) * 8 == 16 && (ImGui::GetIO().BackendFlags & ImGuiBackendFlags_RendererHasVtxOffset) == false;
 
-				vinMin = vin;
-				vinMax = vin;
+			if (showWarning) {
+				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 0, 1));
+				ImGui::TextWrapped("WARNING: ImDrawIdx is 16-bit and ImGuiBackendFlags_RendererHasVtxOffset is false. Expect visual glitches and artifacts!");
+				ImGui::PopStyleColor();
 			}
 
-			vinMin = min(vin, vinMin);
-			vinMax = max(vin, vinMax);
+			ImGui::Text("%s", current.Device->get_name().c_str());
 
-			if (!bPaused) {
-				vinHistory[0].AddPoint(elapsedTime, (float)vin);
-				vinHistory[1].AddPoint(elapsedTime, (float)vinMin);
-				vinHistory[2].AddPoint(elapsedTime, (float)vinMax);
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, .5, 1, 1)); {
+				ImGui::Text("Current Tine      [%f]", elapsedTime);
+				ImGui::Text("Current Position  [%d]", sample.CurrentPosition);
+				ImGui::Text("Request Position  [%d]", current.Target);
+				ImGui::Text("Current Velocity  [%d]", sample.CurrentVelocity / 10000);
+			}ImGui::PopStyleColor();
+
+			ImGui::Separator();
+
+			ImGui::Text("Poll Rate         %.1f Hz%s", current.Acq.GetMeasuredRate(), current.Acq.IsIdle() ? " (idle)" : "");
+			ImGui::Text("Commands          %.1f /s", current.Acq.GetCommandRate());
+			ImGui::Text("USB Transfers     %.1f /s sent %.1f /s saved", current.Queue->GetSentRate(), current.Queue->GetSavedRate());
+			ImGui::Text("Dropped Samples   %llu", (unsigned long long)current.Acq.GetDropped());
+
+			const std::string acqError = current.Acq.GetLastError();
+
+			if (!acqError.empty()) {
+				ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", acqError.c_str());
 			}
 
-			if (!bPaused) {
-				vinHistory[3].AddPoint(elapsedTime, (float)((vinHistory[0].DataAvg.y) / vin) * 100.0f);
-				vinHistory[4].AddPoint(elapsedTime, (float)(vinHistory[0].min / vin) * 100.0f);
-				vinHistory[5].AddPoint(elapsedTime, (float)(vinHistory[0].max / vin) * 100.0f);
+			if (current.Rec.IsOpen()) {
+				ImGui::Text("Recorded          %llu samples, %.1f MB", (unsigned long long)current.Rec.GetWritten(), current.Rec.GetBytes() / (1024.0 * 1024.0));
+				ImGui::Text("Recorder Dropped  %llu", (unsigned long long)current.Rec.GetDropped());
 			}
 
-			if (ImGui::Begin("Information")) {
+			if (contexts.size() > 1) {
 
-				static bool showWarning = sizeof(ImDrawIdx) * 8 == 16 && (ImGui::GetIO().BackendFlags & ImGuiBackendFlags_RendererHasVtxOffset) == false;
+				double total = 0;
 
-				if (showWarning) {
-					ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 0, 1));
-					ImGui::TextWrapped("WARNING: ImDrawIdx is 16-bit and ImGuiBackendFlags_RendererHasVtxOffset is false. Expect visual glitches and artifacts!");
-					ImGui::PopStyleColor();
+				for (auto& context : contexts) {
+					total += context->Acq.GetMeasuredRate();
 				}
 
-				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, .5, 1, 1)); {
-					ImGui::Text("Current Tine      [%f]", elapsedTime);
-					ImGui::Text("Current Position  [%d]", current_position);
-					ImGui::Text("Request Position  [%d]", new_target);
-					ImGui::Text("Current Velocity  [%d]", vars.get_current_velocity() / 10000);
-				}ImGui::PopStyleColor();
+				ImGui::Text("All TICs          %.1f Hz", total);
+			}
 
-				ImGui::Separator();
+			ImGui::Separator();
 
-				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(.5, 1, 1, 1)); {
+			{
+				const TrackingAnalytics& tracking = current.Tracking;
 
-					ImGui::Text("Max Speed         %f", vars.get_max_speed() / 10000.0);
-					ImGui::Text("Starting Speed    %f", vars.get_starting_speed() / 10000.0);
+				ImGui::Text("Tracking RMS      %.1f steps", tracking.Rms());
+				ImGui::Text("Tracking Peak     %.0f steps", tracking.Peak());
+				ImGui::Text("Lag               %.1f ms (%.3f)", tracking.Lag() * 1000.0, tracking.Correlation());
 
-					ImGui::Text("Max Acceleration  %f", vars.get_max_accel() / 100.0);
-					ImGui::Text("Max Deceleration  %f", vars.get_max_decel() / 100.0);
+				ImGui::Text("Moves             %zu", tracking.MoveCount());
 
-					ImGui::Text("Current Limit     %d mA", vars.get_current_limit());
-				}ImGui::PopStyleColor();
+				if (!tracking.Moves().empty()) {
 
-				ImGui::Separator();
+					const TrackingAnalytics::Move& move = tracking.Moves().back();
 
-				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 0, 1)); {
+					ImGui::Text("Last Overshoot    %.0f steps", move.Overshoot);
 
-					ImGui::Text("VIN               %f", vin);
-					ImGui::Text("VIN Avg           %f", vinHistory[0].DataAvg.y);
-					ImGui::Text("VIN Min           %f", vinHistory[0].min);
-					ImGui::Text("VIN Max           %f", vinHistory[0].max);
+					if (move.Settling >= 0) {
+						ImGui::Text("Last Settling     %.0f ms", move.Settling * 1000.0);
+					}
+					else {
+						ImGui::Text("Last Settling     not settled");
+					}
 
-					ImGui::Text("VINAvg Max Diff   %f", (vinHistory[0].max - (vinHistory[0].DataAvg.y)));
-					ImGui::Text("VIN Max Diff      %f", (vinHistory[0].max - vin));
-					ImGui::Text("VINAvg Min Diff   %f", fabs(vinHistory[0].min - (vinHistory[0].DataAvg.y)));
-					ImGui::Text("VIN Min Diff      %f", fabs(vinHistory[0].min - vin));
+					ImGui::Text("Mean Settling     %.0f ms", tracking.MeanSettling() * 1000.0);
+					ImGui::Text("Overshoot Mean    %.1f Max %.0f steps", tracking.MeanOvershoot(), tracking.MaxOvershoot());
+				}
+
+				if (ImGui::Button("Reset##tracking")) {
+					current.Tracking.Reset();
+				}
 
-					ImGui::Text("VIN Avg %%         %f", (vinHistory[0].DataAvg.y / vin) * 100.0);
-					ImGui::Text("VIN Avg %%         %f", (vinHistory[0].min / vin) * 100.0);
-					ImGui::Text("VIN Avg %%         %f", (vinHistory[0].max / vin) * 100.0);
-					ImGui::Text("VIN Max %%         %f", fabs(vinHistory[0].max - vin));
+				ImGui::SameLine();
 
-				} ImGui::PopStyleColor();
+				static std::string exported;
 
-			}
+				if (ImGui::Button("Export##tracking")) {
 
-			handle.exit_safe_start();
+					const std::string path = RecordingName(current, ".csv");
 
-			if (current_position != new_target) {
-				handle.set_target_position(new_target);
+					exported = tracking.Export(path) ? path : "can't write " + path;
+				}
+
+				if (!exported.empty()) {
+					ImGui::SameLine();
+					ImGui::Text("%s", exported.c_str());
+				}
 			}
-		}
-		catch (const std::exception& error) {
-			std::cerr << "Error: " << error.what() << std::endl;
-			return 1;
+
+			ImGui::Separator();
+
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(.5, 1, 1, 1)); {
+
+				ImGui::Text("Max Speed         %f", sample.MaxSpeed / 10000.0);
+				ImGui::Text("Starting Speed    %f", sample.StartingSpeed / 10000.0);
+
+				ImGui::Text("Max Acceleration  %f", sample.MaxAccel / 100.0);
+				ImGui::Text("Max Deceleration  %f", sample.MaxDecel / 100.0);
+
+				ImGui::Text("Current Limit     %d mA", sample.CurrentLimit);
+			}ImGui::PopStyleColor();
+
+			ImGui::Separator();
+
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1, 1, 0, 1)); {
+
+				ImGui::Text("VIN               %f", vin);
+				ImGui::Text("VIN Avg           %f", vinAvg);
+				ImGui::Text("VIN Min           %f", vinLow);
+				ImGui::Text("VIN Max           %f", vinHigh);
+
+				ImGui::Text("VINAvg Max Diff   %f", (vinHigh - vinAvg));
+				ImGui::Text("VIN Max Diff      %f", (vinHigh - vin));
+				ImGui::Text("VINAvg Min Diff   %f", fabs(vinLow - vinAvg));
+				ImGui::Text("VIN Min Diff      %f", fabs(vinLow - vin));
+
+				ImGui::Text("VIN Avg %%         %f", (vinAvg / vin) * 100.0);
+				ImGui::Text("VIN Avg %%         %f", (vinLow / vin) * 100.0);
+				ImGui::Text("VIN Avg %%         %f", (vinHigh / vin) * 100.0);
+				ImGui::Text("VIN Max %%         %f", fabs(vinHigh - vin));
+
+			} ImGui::PopStyleColor();
+
 		}
 	}
 	ImGui::End();
 
 	if (ImGui::Begin("Trainer")) {
 
-		/// <summary>
-		///  each of the trainer modes
-		/// </summary>
-		enum class TrainMode {
-			NONE,
-			IDLE,
-			IDLE_COLLECT,
-			ENERGISED,
-			ENERGISED_COLLECT,
-			SLOW,
-			SLOW_COLLECT,
-			FASTER,
-			FASTER_COLLECT,
-			LOAD,
-			LOAD_COLLECT,
-			DONE
+		// one row per phase, the ticked ones run top to bottom on the trainer thread
+		struct PhaseConfig {
+			const char* Name;
+			bool bRun;
+			bool bEnergised;
+			int Profile;
+			float Duration;
 		};
 
-		// which mode is trainer in
-		static TrainMode mTrainMode = TrainMode::NONE;
+		static PhaseConfig phases[] = {
+			{ "Idle", true, false, -1, 30 },
+			{ "Energised", true, true, -1, 30 },
+			{ "Slow", true, true, FindProfile("SIN"), 30 },
+			{ "Faster", true, true, FindProfile("SIN 3"), 30 },
+			{ "Load", true, true, FindProfile("PING PONG"), 30 },
+		};
 
-		// training enabled
-		static bool bTraining = false;
+		const std::vector<ProfileEntry>& library = ProfileLibrary();
 
-		// countdown timer in seconds for each train mode
-		static float iTrainTimer = 0;
+		for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
 
-		// set when data collected for each mode is valid 
-		static bool bIdleDataValid = false, bEnergisedDataValid = false, bSlowDataValid = false, bFasterDataValid = false, bLoadDataValid = false;
+			PhaseConfig& config = phases[i];
 
-		// recorded min/max for each mode
-		static double idleMax = DBL_MIN, idleMin = DBL_MAX;
-		static double energisedMax = DBL_MIN, energisedMin = DBL_MAX;
-		static double slowMax = DBL_MIN, slowMin = DBL_MAX;
-		static double fasterMax = DBL_MIN, fasterMin = DBL_MAX;
-		static double loadMax = DBL_MIN, loadMin = DBL_MAX;
+			ImGui::PushID((int)i);
 
-		if (ImGui::Button("Train")) {
+			ImGui::Checkbox(config.Name, &config.bRun);
+			ImGui::SameLine(120);
+			ImGui::Checkbox("Energised", &config.bEnergised);
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(120);
 
-			bTraining = true;
-			mTrainMode = TrainMode::IDLE;
-			bIdleDataValid = false;
-			bEnergisedDataValid = false;
-			bSlowDataValid = false;
-			bFasterDataValid = false;
-			bLoadDataValid = false;
-		}
+			if (ImGui::BeginCombo("##profile", config.Profile < 0 ? "Hold" : library[config.Profile].Name)) {
 
-		// not using yet
-		static int iTorqueBias = 0;
-		static int iSpeedBias = 0;
-		static int iAccelBias = 0;
+				if (ImGui::Selectable("Hold", config.Profile < 0)) {
+					config.Profile = -1;
+				}
 
-		if (ImGui::SliderInt("Torque##torque", &iTorqueBias, -100, 100)) {
-		}
+				for (size_t p = 0; p < library.size(); p++) {
+					if (ImGui::Selectable(library[p].Name, config.Profile == (int)p)) {
+						config.Profile = (int)p;
+					}
+				}
 
-		if (ImGui::SliderInt("Speed##speed", &iSpeedBias, -100, 100)) {
-		}
+				ImGui::EndCombo();
+			}
+
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(120);
+			ImGui::SliderFloat("s##duration", &config.Duration, 1, 120, "%.0f s");
 
-		if (ImGui::SliderInt("Accel##accel", &iAccelBias, -100, 100)) {
+			ImGui::PopID();
 		}
 
-		if (bTraining) {
+		if (!trainer.IsRunning()) {
 
-			switch (mTrainMode) {
+			if (ImGui::Button("Train") && selected && !tuner.IsTuning(*selected) && !sync.IsDriving(&selected->Acq)) {
 
-			case TrainMode::NONE:
-				break;
+				std::vector<TrainerPhase> run;
 
-			case TrainMode::IDLE:
-				// turn off motors
-				handle.deenergize();
+				for (const PhaseConfig& config : phases) {
 
-				// 30 seconds training time
-				iTrainTimer = (30 + elapsedTime);
-				mTrainMode = TrainMode::IDLE_COLLECT;
-				break;
+					if (!config.bRun) {
+						continue;
+					}
 
-			case TrainMode::IDLE_COLLECT:
+					TrainerPhase phase;
 
-				// next mode
-				if (elapsedTime > iTrainTimer) {
+					phase.Name = config.Name;
+					phase.Duration = config.Duration;
+					phase.bEnergised = config.bEnergised;
 
-					idleMax = vinHistory[0].max;
-					idleMin = vinHistory[0].min;
+					// tables are worked out here, the trainer thread only swaps them in
+					if (config.Profile >= 0) {
 
-					mTrainMode = TrainMode::ENERGISED;
-					iTrainTimer = (30 + elapsedTime);
+						SetpointTable table = BuildProfileTable(*selected, config.Profile, ProfileRate);
 
-					bIdleDataValid = true;
+						table.bVelocity = selected->bVelocityControl;
 
-					break;
+						phase.Table = std::make_shared<const SetpointTable>(std::move(table));
+					}
+
+					run.push_back(std::move(phase));
 				}
 
-				ImGui::Text("Collecting idle data");
+				selected->Profile = -1;
+
+				trainer.Start(*selected, std::move(run));
+			}
+		}
+		else if (ImGui::Button("Cancel##train")) {
+			trainer.Stop();
+		}
+
+		const std::vector<TrainerStats> stats = trainer.GetStats();
+
+		const int phase = trainer.GetPhase();
+
+		if (phase >= 0 && phase < (int)stats.size()) {
+			ImGui::SameLine();
+			ImGui::Text("Collecting %s data, %.0f s left", stats[phase].Name.c_str(), trainer.GetRemaining());
+		}
 
-				break;
+		const std::string trainError = trainer.GetLastError();
 
-			case TrainMode::ENERGISED:
-				// turn on motors
-				handle.energize();
-				_bEnableTIC = true;
+		if (!trainError.empty()) {
+			ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", trainError.c_str());
+		}
 
-				// 30 seconds training time
-				iTrainTimer = (30 + elapsedTime);
-				mTrainMode = TrainMode::ENERGISED_COLLECT;
-				break;
+		if (!stats.empty() && ImGui::BeginTable("##trainstats", 9, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
 
-			case TrainMode::ENERGISED_COLLECT:
+			ImGui::TableSetupColumn("VIN");
+			ImGui::TableSetupColumn("Samples");
+			ImGui::TableSetupColumn("Mean");
+			ImGui::TableSetupColumn("Std Dev");
+			ImGui::TableSetupColumn("Min");
+			ImGui::TableSetupColumn("P1");
+			ImGui::TableSetupColumn("P50");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableSetupColumn("Max");
+			ImGui::TableHeadersRow();
 
-				// next mode
-				if (elapsedTime > iTrainTimer) {
+			for (const TrainerStats& result : stats) {
 
-					energisedMax = vinHistory[0].max;
-					energisedMin = vinHistory[0].min;
+				const RunningStats& vin = result.Vin.Stats;
 
-					mTrainMode = TrainMode::SLOW;
-					iTrainTimer = (30 + elapsedTime);
+				if (vin.Samples() == 0) {
+					continue;
+				}
 
-					bEnergisedDataValid = true;
+				ImGui::TableNextRow();
 
-					break;
+				// still collecting, or cancelled part way
+				if (!result.bValid) {
+					ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(ImVec4(0.5f, 0.5f, 0, 0.4f)));
 				}
 
-				ImGui::Text("Collecting energised data");
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", result.Name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)vin.Samples());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", vin.Avg());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.4f", vin.StdDev());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", vin.Min());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", result.Vin.P1.Get());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", result.Vin.P50.Get());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", result.Vin.P99.Get());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", vin.Max());
+			}
 
-				break;
+			ImGui::EndTable();
 
-			case TrainMode::SLOW:
+			// each phase's share of samples per bin, so phases of any length overlay
+			const size_t bins = TrainerStats::HistogramBins;
+			const double width = (TrainerStats::HistogramHigh - TrainerStats::HistogramLow) / bins;
 
-				// turn on motors
-				handle.energize();
-				_bEnableTIC = true;
+			size_t first = bins, last = 0;
 
-				// 30 seconds training time
-				iTrainTimer = (30 + elapsedTime);
-				mTrainMode = TrainMode::SLOW_COLLECT;
-				mMode = Modes::mSIN;
+			for (const TrainerStats& result : stats) {
 
-				break;
+				const std::vector<uint64_t>& counts = result.Vin.Bins.Bins();
 
-			case TrainMode::SLOW_COLLECT:
+				for (size_t i = 0; i < counts.size(); i++) {
+					if (counts[i]) {
+						first = (i < first) ? i : first;
+						last = (i > last) ? i : last;
+					}
+				}
+			}
 
-				// next mode
-				if (elapsedTime > iTrainTimer) {
+			if (first <= last && ImPlot::BeginPlot("VIN by Phase##trainHistogram", "VIN", "fraction", ImVec2(-1, 200), 0, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit)) {
 
-					slowMax = vinHistory[0].max;
-					slowMin = vinHistory[0].min;
+				// a bin either side so the stairs close
+				first = (first > 0) ? first - 1 : first;
+				last = (last + 1 < bins) ? last + 1 : last;
 
-					mTrainMode = TrainMode::FASTER;
-					iTrainTimer = (30 + elapsedTime);
+				std::vector<double> xs(last - first + 1), ys(last - first + 1);
 
-					bSlowDataValid = true;
+				for (const TrainerStats& result : stats) {
 
-					break;
+					const uint64_t samples = result.Vin.Stats.Samples();
+
+					if (samples == 0) {
+						continue;
+					}
+
+					for (size_t i = first; i <= last; i++) {
+						xs[i - first] = TrainerStats::HistogramLow + i * width;
+						ys[i - first] = (double)result.Vin.Bins.Bins()[i] / samples;
+					}
+
+					ImPlot::PlotStairs(result.Name.c_str(), xs.data(), ys.data(), (int)xs.size());
 				}
 
-				ImGui::Text("Collecting slow data");
+				ImPlot::EndPlot();
+			}
+		}
 
-				break;
+		static std::string trainExported;
 
-			case TrainMode::FASTER:
+		if (!stats.empty() && selected && ImGui::Button("Export##train")) {
 
-				// turn on motors
-				handle.energize();
-				_bEnableTIC = true;
+			const std::string path = RecordingName(*selected, "-train.csv");
 
-				// 30 seconds training time
-				iTrainTimer = (30 + elapsedTime);
-				mTrainMode = TrainMode::FASTER_COLLECT;
+			trainExported = trainer.Export(path) ? path : "can't write " + path;
+		}
 
-				mMode = Modes::mSIN3;
+		if (!trainExported.empty()) {
+			ImGui::SameLine();
+			ImGui::Text("%s", trainExported.c_str());
+		}
 
-				break;
+		if (ImGui::CollapsingHeader("Auto Tune")) {
 
-			case TrainMode::FASTER_COLLECT:
+			static SweepTuner::Config tune;
 
-				// next mode
-				if (elapsedTime > iTrainTimer) {
+			int search = (int)tune.Mode;
 
-					fasterMax = vinHistory[0].max;
-					fasterMin = vinHistory[0].min;
+			ImGui::RadioButton("Coordinate##tune", &search, (int)SweepTuner::Search::Coordinate);
+			ImGui::SameLine();
+			ImGui::RadioButton("Grid##tune", &search, (int)SweepTuner::Search::Grid);
 
-					mTrainMode = TrainMode::LOAD;
-					iTrainTimer = (30 + elapsedTime);
+			tune.Mode = (SweepTuner::Search)search;
 
-					bFasterDataValid = true;
+			float distance = (float)tune.Distance, dwell = (float)tune.Dwell, sag = (float)tune.MaxSag;
 
-					break;
-				}
+			if (ImGui::SliderFloat("Distance steps##tune", &distance, 10, 2000, "%.0f")) {
+				tune.Distance = distance;
+			}
 
-				ImGui::Text("Collecting faster data");
+			if (ImGui::SliderFloat("Dwell s##tune", &dwell, 0.2f, 5.0f, "%.1f")) {
+				tune.Dwell = dwell;
+			}
+
+			if (ImGui::SliderFloat("Max Sag V##tune", &sag, 0.05f, 3.0f, "%.2f")) {
+				tune.MaxSag = sag;
+			}
+
+			float speedMin = (float)tune.SpeedMin, speedMax = (float)tune.SpeedMax;
+			float accelMin = (float)tune.AccelMin, accelMax = (float)tune.AccelMax;
+			int currentMin = (int)tune.CurrentMin, currentMax = (int)tune.CurrentMax;
+
+			if (ImGui::DragFloatRange2("Speed steps/s##tune", &speedMin, &speedMax, 10, 10, 50000, "%.0f")) {
+				tune.SpeedMin = speedMin;
+				tune.SpeedMax = speedMax;
+			}
+
+			if (ImGui::DragFloatRange2("Accel steps/s2##tune", &accelMin, &accelMax, 50, 10, 200000, "%.0f")) {
+				tune.AccelMin = accelMin;
+				tune.AccelMax = accelMax;
+			}
+
+			if (ImGui::DragIntRange2("Current mA##tune", &currentMin, &currentMax, 10, 0, 3968)) {
+				tune.CurrentMin = (uint32_t)currentMin;
+				tune.CurrentMax = (uint32_t)currentMax;
+			}
+
+			ImGui::DragIntRange2("Step Mode##tune", &tune.StepModeMin, &tune.StepModeMax, 0.1f, 0, 9);
+			ImGui::SliderInt("Points##tune", &tune.Points, 2, 10);
 
-				break;
+			if (!tuner.IsRunning()) {
+				if (ImGui::Button("Start##tune") && selected && !trainer.IsTraining(*selected) && !sync.IsDriving(&selected->Acq)) {
+					tuner.Start(*selected, tune);
+				}
+			}
+			else if (ImGui::Button("Stop##tune")) {
+				tuner.Stop();
+			}
 
-			case TrainMode::LOAD:
+			ImGui::SameLine();
+			ImGui::Text("%zu / %zu  %s", tuner.Tested(), tuner.Planned(), tuner.Status());
 
-				// turn on motors
-				handle.energize();
-				_bEnableTIC = true;
+			const std::string tuneError = tuner.GetError();
 
-				// 30 seconds training time
-				iTrainTimer = (30 + elapsedTime);
-				mTrainMode = TrainMode::LOAD_COLLECT;
+			if (!tuneError.empty()) {
+				ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", tuneError.c_str());
+			}
 
-				mMode = Modes::mPINGPONG;
+			if (tuner.IsRunning()) {
+				const TunerCandidate candidate = tuner.GetCurrent();
 
-				break;
+				ImGui::Text("Trying %.0f steps/s %.0f steps/s2 %u mA %s", candidate.Speed, candidate.Accel, candidate.CurrentLimit, stepModes[candidate.StepMode]);
+			}
 
-			case TrainMode::LOAD_COLLECT:
+			const std::vector<TunerResult> results = tuner.GetResults();
+			const size_t best = tuner.GetBest();
 
-				// next mode
-				if (elapsedTime > iTrainTimer) {
+			if (!results.empty() && ImGui::BeginTable("##tuneresults", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200))) {
 
-					loadMax = vinHistory[0].max;
-					loadMin = vinHistory[0].min;
+				ImGui::TableSetupScrollFreeze(0, 1);
+				ImGui::TableSetupColumn("Speed");
+				ImGui::TableSetupColumn("Accel");
+				ImGui::TableSetupColumn("mA");
+				ImGui::TableSetupColumn("Step");
+				ImGui::TableSetupColumn("Settle ms");
+				ImGui::TableSetupColumn("Overshoot");
+				ImGui::TableSetupColumn("Sag V");
+				ImGui::TableSetupColumn("Stable");
+				ImGui::TableHeadersRow();
 
-					mTrainMode = TrainMode::DONE;
-					iTrainTimer = 0;
+				for (size_t i = 0; i < results.size(); i++) {
 
-					mMode = Modes::mNONE;
+					const TunerResult& result = results[i];
 
-					bLoadDataValid = true;
+					ImGui::TableNextRow();
 
-					// motors off
-					handle.deenergize();
-					_bEnableTIC = false;
+					// the one that'll be kept
+					if (i == best) {
+						ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg0, ImGui::GetColorU32(ImVec4(0, 0.5f, 0, 0.6f)));
+					}
 
-					break;
+					ImGui::TableNextColumn();
+					ImGui::Text("%.0f", result.Candidate.Speed);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.0f", result.Candidate.Accel);
+					ImGui::TableNextColumn();
+					ImGui::Text("%u", result.Candidate.CurrentLimit);
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", stepModes[result.Candidate.StepMode]);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.0f", result.Settling * 1000.0);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.1f", result.Overshoot);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.2f", result.Sag);
+					ImGui::TableNextColumn();
+					ImGui::Text(result.bStable ? "yes" : (result.Errors ? "errors" : "no"));
 				}
 
-				ImGui::Text("Collecting load data");
+				ImGui::EndTable();
+			}
+
+			static std::string exported;
+
+			if (!results.empty() && selected && ImGui::Button("Export##tune")) {
 
-				break;
+				const std::string path = RecordingName(*selected, "-tune.csv");
+
+				exported = tuner.Export(path) ? path : "can't write " + path;
+			}
+
+			if (!exported.empty()) {
+				ImGui::SameLine();
+				ImGui::Text("%s", exported.c_str());
 			}
 		}
-		if (bTraining) {
+	}
+
+	ImGui::End();
+
+	// x range shown while replaying, shared by the Data plots so panning one pans them all
+	static double replayFrom = 0, replayTo = 10;
 
-			int iCount = (int)(iTrainTimer - elapsedTime);
+	// what is loaded into replayed, a span either side of the view so panning rarely reloads
+	static TelemetryStore replayed(Replay::Budget);
+	static double loadedFrom = 0, loadedTo = 0;
+	static bool bReplayReduced = false;
+	static bool bReplayDirty = false;
 
-			if (ImGui::SliderInt("Time##time", &iCount, 0, (int)( iTrainTimer - elapsedTime ))) {
+	if (ImGui::Begin("Replay")) {
+
+		static char replayPath[512] = "";
+
+		ImGui::InputText("File##replayPath", replayPath, sizeof(replayPath));
+		ImGui::SameLine();
+
+		if (ImGui::Button("Open##replayOpen")) {
+
+			if (replay.Open(replayPath)) {
+				replayFrom = replay.StartTime();
+				replayTo = replayFrom + 10.0;
+				bReplayDirty = true;
 			}
 		}
 
-		if (bIdleDataValid) {
-			ImGui::Text("Idle Min      %f", idleMin);
-			ImGui::Text("Idle Max      %f", idleMax);
+		if (!replay.IsOpen() && !replay.GetError().empty()) {
+			ImGui::Text("%s", replay.GetError().c_str());
 		}
 
-		if (bEnergisedDataValid) {
-			ImGui::Text("Energised Min %f", energisedMin);
-			ImGui::Text("Energised Max %f", energisedMax);
-		}
+		if (replay.IsOpen()) {
 
-		if (bSlowDataValid) {
-			ImGui::Text("Slow Min      %f", slowMin);
-			ImGui::Text("Slow Max      %f", slowMax);
-		}
+			ImGui::SameLine();
 
-		if (bFasterDataValid) {
-			ImGui::Text("Faster Min    %f", fasterMin);
-			ImGui::Text("Faster Max    %f", fasterMax);
+			if (ImGui::Button("Close##replayClose")) {
+				replay.Close();
+				replayed.Erase();
+			}
 		}
 
-		if (bLoadDataValid) {
-			ImGui::Text("Loaded Min    %f", loadMin);
-			ImGui::Text("Loaded Max    %f", loadMax);
+		if (replay.IsOpen()) {
+
+			ImGui::Text("%llu samples, %.1f s, %.1f MB",
+				(unsigned long long)replay.SampleCount(),
+				replay.EndTime() - replay.StartTime(),
+				replay.FileSize() / (1024.0 * 1024.0)
+			);
+
+			const double start = replay.StartTime();
+			const double end = replay.EndTime();
+
+			double span = replayTo - replayFrom;
+			double at = replayTo;
+
+			if (ImGui::SliderScalar("Time##replayTime", ImGuiDataType_Double, &at, &start, &end, "%.3f")) {
+				replayFrom = at - span;
+				replayTo = at;
+			}
+
+			const double shortest = 0.01;
+			const double longest = (end - start > shortest) ? end - start : shortest;
+
+			if (ImGui::SliderScalar("Span##replaySpan", ImGuiDataType_Double, &span, &shortest, &longest, "%.3f s", ImGuiSliderFlags_Logarithmic)) {
+				replayFrom = replayTo - span;
+			}
+
+			if (bReplayReduced) {
+				ImGui::Text("Showing min/max of %d rows", replayed.Size());
+			}
 		}
 	}
 
 	ImGui::End();
 
+	if (replay.IsOpen()) {
+
+		const double span = replayTo - replayFrom;
+
+		// reload once the view leaves what is loaded, or zooms well into a reduced load
+		if (bReplayDirty || replayFrom < loadedFrom || replayTo > loadedTo || (bReplayReduced && span * 6 < loadedTo - loadedFrom)) {
+
+			loadedFrom = replayFrom - span;
+			loadedTo = replayTo + span;
+
+			bReplayReduced = replay.Load(replayed, loadedFrom, loadedTo);
+			bReplayDirty = false;
+		}
+	}
+
+	// live telemetry, or the recording being replayed
+	const TelemetryStore& shown = replay.IsOpen() ? replayed : current.Telemetry;
+
+	auto SetNextPlotX = [&]() {
+		if (replay.IsOpen()) {
+			ImPlot::LinkNextPlotLimits(&replayFrom, &replayTo, NULL, NULL);
+		}
+		else {
+			ImPlot::SetNextPlotLimitsX(elapsedTime - 10.0, elapsedTime, bPaused ? ImGuiCond_Once : ImGuiCond_Always);
+		}
+	};
+
 	if (ImGui::Begin("Data")) {
 
-		if (ImGui::SliderInt("Target Position##ticTune1", &new_target, GetRange(step_mode , LOWER_RANGE ), GetRange(step_mode))) {
-			handle.set_target_position(new_target);
+		if (ImGui::SliderInt("Target Position##ticTune1", &current.Target, GetRange(current.step_mode , LOWER_RANGE ), GetRange(current.step_mode))) {
+			current.Acq.SetTarget(current.Target);
 		}
 		ImGui::SameLine();
 
+		// overlay every TIC's position on the selected one's plot
+		static bool bShowAll = false;
+
+		if (contexts.size() > 1) {
+			ImGui::Checkbox("All TICs", &bShowAll);
+			ImGui::SameLine();
+		}
+
 		static ImPlotAxisFlags xflags = ImPlotAxisFlags_None;
 		static ImPlotAxisFlags yflags = ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_RangeFit;
 
@@ -880,32 +1471,30 @@ int RenderGUI()
 
 		ImPlot::SetNextPlotLimitsY(-1610, 210);
 
-		ImPlot::SetNextPlotLimitsX(elapsedTime - 10.0, elapsedTime, bPaused ? ImGuiCond_Once : ImGuiCond_Always);
+		SetNextPlotX();
 
 		if (ImPlot::BeginPlot("Motor Position", "time", "pos", ImVec2(-1, 0), 0, xflags, yflags)) {
 
-			for (int i = 0; i < 3; i++) {
+			ImPlot::SetNextLineStyle(ImVec4(1, 1, 1, 1));
+			shown.PlotLine("Target", shown.Target);
 
-				if (positionHistory[i].Data.size()) {
+			ImPlot::SetNextLineStyle(ImVec4(0, 1, 1, 1));
+			shown.PlotLine("Current", shown.Position);
 
-					switch (i) {
+			ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
+			shown.PlotLine("Velocity", shown.Velocity);
 
-					case 0:
-						ImPlot::SetNextLineStyle(ImVec4(1, 1, 1, 1));
-						break;
+			if (bShowAll && !replay.IsOpen()) {
 
-					case  1:
-						ImPlot::SetNextLineStyle(ImVec4(0, 1, 1, 1));
-						break;
+				for (size_t i = 0; i < contexts.size(); i++) {
 
-					case  2:
-						ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
-						break;
+					if (contexts[i].get() == &current) {
+						continue;
 					}
 
-					const char names[][20] = { "Target", "Current", "Velocity" };
+					const std::string label = contexts[i]->Device->get_name() + "##position" + std::to_string(i);
 
-					ImPlot::PlotLine(names[i], &positionHistory[i].Data[0].x, &positionHistory[i].Data[0].y, positionHistory[i].Data.size(), positionHistory[i].Offset, 2 * sizeof(float));
+					contexts[i]->Telemetry.PlotLine(label.c_str(), contexts[i]->Telemetry.Position);
 				}
 			}
 
@@ -914,38 +1503,34 @@ int RenderGUI()
 
 		ImPlot::SetNextPlotLimitsY(-1610, 210);
 
-		ImPlot::SetNextPlotLimitsX(elapsedTime - 10.0, elapsedTime, bPaused ? ImGuiCond_Once : ImGuiCond_Always);
+		SetNextPlotX();
 
 		if (ImPlot::BeginPlot("VIN History##vinHistory", "time", "VIN", ImVec2(-1, 0), 0, xflags, yflags)) {
 
-			if (vinHistory[0].Data.size()) {
-
-				ImPlot::SetNextLineStyle(ImVec4(1, 1, .5, 1));
-				ImPlot::PlotLine("VIN##vin", &vinHistory[0].Data[0].x, &vinHistory[0].Data[0].y, vinHistory[0].Data.size(), vinHistory[0].Offset, 2 * sizeof(float));
-				ImPlot::SetNextLineStyle(ImVec4(.5, 1, 1, 1));
-				ImPlot::PlotLine("min##vinmin", &vinHistory[1].Data[0].x, &vinHistory[1].Data[0].y, vinHistory[1].Data.size(), vinHistory[1].Offset, 2 * sizeof(float));
-				ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
-				ImPlot::PlotLine("max##vinmax", &vinHistory[2].Data[0].x, &vinHistory[2].Data[0].y, vinHistory[2].Data.size(), vinHistory[2].Offset, 2 * sizeof(float));
-			}
+			ImPlot::SetNextLineStyle(ImVec4(1, 1, .5, 1));
+			shown.PlotLine("VIN##vin", shown.Vin);
+			ImPlot::SetNextLineStyle(ImVec4(.5, 1, 1, 1));
+			shown.PlotLine("min##vinmin", shown.VinMin);
+			ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
+			shown.PlotLine("max##vinmax", shown.VinMax);
 
 			ImPlot::EndPlot();
 		}
 
 		ImPlot::SetNextPlotLimitsY(-1610, 210);
 
-		ImPlot::SetNextPlotLimitsX(elapsedTime - 10.0, elapsedTime, bPaused ? ImGuiCond_Once : ImGuiCond_Always);
+		SetNextPlotX();
 		if (ImPlot::BeginPlot("VIN History##vinAvgHistory", "time", "%", ImVec2(-1, 0), 0, xflags, yflags)) {
 
 			ImPlot::PushColormap(ImPlotColormap_Plasma); {
 
-				if (vinHistory[3].Data.size()) {
-					ImPlot::SetNextLineStyle(ImVec4(1, 1, 1, 1));
-					ImPlot::PlotLine("VinAvg##vin", &vinHistory[3].Data[0].x, &vinHistory[3].Data[0].y, vinHistory[3].Data.size(), vinHistory[3].Offset, 2 * sizeof(float));
-					ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
-					ImPlot::PlotLine("VinMin##vinmin", &vinHistory[4].Data[0].x, &vinHistory[4].Data[0].y, vinHistory[4].Data.size(), vinHistory[4].Offset, 2 * sizeof(float));
-					ImPlot::SetNextLineStyle(ImVec4(0, 1, 0, 1));
-					ImPlot::PlotLine("VinMax##vinmax", &vinHistory[5].Data[0].x, &vinHistory[5].Data[0].y, vinHistory[5].Data.size(), vinHistory[5].Offset, 2 * sizeof(float));
-				}
+				ImPlot::SetNextLineStyle(ImVec4(1, 1, 1, 1));
+				shown.PlotLine("VinAvg##vin", shown.VinAvgPct);
+				ImPlot::SetNextLineStyle(ImVec4(1, 0, 1, 1));
+				shown.PlotLine("VinMin##vinmin", shown.VinMinPct);
+				ImPlot::SetNextLineStyle(ImVec4(0, 1, 0, 1));
+				shown.PlotLine("VinMax##vinmax", shown.VinMaxPct);
+
 
 				ImPlot::EndPlot();
 			} ImPlot::PopColormap();
@@ -956,78 +1541,244 @@ int RenderGUI()
 
 	if (ImGui::Begin("Motor Config")) {
 		{
-			ImGui::Checkbox("Invert", &bInvertMotor);
+			ImGui::Checkbox("Invert", &current.bInvertMotor);
 			ImGui::SameLine();
-			ImGui::Checkbox("Auto Update", &bAutoUpdate);
+			if (ImGui::Checkbox("Auto Update", &bAutoUpdate) && bAutoUpdate) {
+				bLiveTune = false;
+			}
+
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Write each change as Update does, turns Live Tune off");
+			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Checkbox("Live Tune", &bLiveTune) && bLiveTune) {
+				bAutoUpdate = false;
+			}
+
+			if (ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Send runtime fields straight to the TIC, nothing stored, turns Auto Update off");
+			}
+
 			ImGui::SameLine();
 			ImGui::Checkbox("One Accel", &bOneAccel);
 
-			if (DrawSlider("Max Speed", iMaxSpeed, 0, 500000000)) {
-				tic_settings_set_max_speed(settings.get_pointer(), iMaxSpeed);
-				bChanged = true;
+			if (DrawSlider("Max Speed", current.iMaxSpeed, 0, 500000000)) {
+				tic_settings_set_max_speed(current.Settings.get_pointer(), current.iMaxSpeed);
+				current.bChanged = true;
 			}
 
-			if (DrawSlider("Starting Speed", iStartingSpeed, 0, 500000000)) {
-				tic_settings_set_starting_speed(settings.get_pointer(), iStartingSpeed);
-				bChanged = true;
+			if (DrawSlider("Starting Speed", current.iStartingSpeed, 0, 500000000)) {
+				tic_settings_set_starting_speed(current.Settings.get_pointer(), current.iStartingSpeed);
+				current.bChanged = true;
 			}
 
-			if (DrawSlider("Max Acceleration", iMaxAcceleration, 100, 2147483647 / 20)) {
-				tic_settings_set_max_accel(settings.get_pointer(), iMaxAcceleration);
+			if (DrawSlider("Max Acceleration", current.iMaxAcceleration, 100, 2147483647 / 20)) {
+				tic_settings_set_max_accel(current.Settings.get_pointer(), current.iMaxAcceleration);
 
 				if (bOneAccel == true) {
-					tic_settings_set_max_decel(settings.get_pointer(), iMaxDeceleration);
+					tic_settings_set_max_decel(current.Settings.get_pointer(), current.iMaxDeceleration);
 				}
 
-				bChanged = true;
+				current.bChanged = true;
 			}
 		}
 
 		if (bOneAccel == false) {
-			if (DrawSlider("Max Deceleration", iMaxDeceleration, 100, 2147483647 / 20)) {
-				tic_settings_set_max_decel(settings.get_pointer(), iMaxDeceleration);
-				bChanged = true;
+			if (DrawSlider("Max Deceleration", current.iMaxDeceleration, 100, 2147483647 / 20)) {
+				tic_settings_set_max_decel(current.Settings.get_pointer(), current.iMaxDeceleration);
+				current.bChanged = true;
 			}
 		}
 
-		if (ImGui::SliderInt("Step Mode##stepMode", &step_mode, 0, 5)) {
-			tic_settings_set_step_mode(settings.get_pointer(), step_mode);
-			bChanged = true;
+		if (ImGui::SliderInt("Step Mode##stepMode", &current.step_mode, 0, 5)) {
+			tic_settings_set_step_mode(current.Settings.get_pointer(), current.step_mode);
+			current.bChanged = true;
+
+			// the profile's table was mapped onto the old step mode's range
+			if (current.Profile >= 0) {
+				ApplyProfile(current, current.Profile);
+			}
 		}
 
 		ImGui::SameLine();
-		ImGui::Text("%s", stepModes[step_mode]);
+		ImGui::Text("%s", stepModes[current.step_mode]);
 
 		// current limit
-		if (ImGui::SliderInt("Current Limit##currentLimit", &current_limit, 0, 1024)) {
-			tic_settings_set_current_limit(settings.get_pointer(), current_limit);
-			current_limit = tic_settings_get_current_limit(settings.get_pointer());
-			bChanged = true;
+		if (ImGui::SliderInt("Current Limit##currentLimit", &current.current_limit, 0, 1024)) {
+			tic_settings_set_current_limit(current.Settings.get_pointer(), current.current_limit);
+			current.current_limit = tic_settings_get_current_limit(current.Settings.get_pointer());
+			current.bChanged = true;
 		}
 
 		// decay mode
-		if (ImGui::SliderInt("Decay Mode##decayMode", &decay_mode, 0, 2)) {
-			tic_settings_set_decay_mode(settings.get_pointer(), decay_mode);
-			bChanged = true;
+		if (ImGui::SliderInt("Decay Mode##decayMode", &current.decay_mode, 0, 2)) {
+			tic_settings_set_decay_mode(current.Settings.get_pointer(), current.decay_mode);
+			current.bChanged = true;
 		}
 
 		ImGui::SameLine();
 
-		ImGui::Text("%s", decayModes[decay_mode]);
+		ImGui::Text("%s", decayModes[current.decay_mode]);
+
+		// straight to the running TIC without a reinitialize, nothing stored until committed
+		if (current.bChanged && bLiveTune) {
+
+			current.Acq.Post([settings = current.Settings](TicDevice& device) {
+				SendRuntimeSettings(device, settings);
+			});
 
-		if (ImGui::Button("Update") || (bChanged && bAutoUpdate)) {
+			current.bChanged = false;
+		}
+
+		// one write in flight at a time, auto update picks up anything changed meanwhile
+		const bool bWaiting = current.SettingsReply.valid();
+
+		if ((ImGui::Button("Update") || (current.bChanged && bAutoUpdate)) && !bWaiting) {
+
+			// only what changed, the runtime fields without touching the TIC's EEPROM
+			current.SettingsReply = current.Acq.Post([stored = current.Stored, settings = current.Settings](TicDevice& device) {
+				return WriteSettings(device, stored, settings);
+			});
 
-			handle.set_settings(settings);
-			handle.reinitialize();
-			settings = handle.get_settings();
+			current.bChanged = false;
+		}
+
+		ImGui::SameLine();
 
-			bChanged = false;
+		if (ImGui::Button("Refresh") && !bWaiting) {
+			current.SettingsReply = current.Acq.Post([](TicDevice& device) { return device.get_settings(); });
+			current.bRefreshing = true;
 		}
 
 		ImGui::SameLine();
 
-		if (ImGui::Button("Refresh")) {
-			settings = handle.get_settings();
+		// keep what's been tuned live, the runtime fields are stored without interrupting motion
+		const int uncommitted = ChangedFields(current.Stored, current.Settings);
+
+		ImGui::BeginDisabled(bWaiting || uncommitted == 0);
+
+		if (ImGui::Button("Commit to Flash")) {
+
+			current.SettingsReply = current.Acq.Post([stored = current.Stored, settings = current.Settings](TicDevice& device) {
+				return CommitSettings(device, stored, settings);
+			});
+		}
+
+		ImGui::EndDisabled();
+
+		if (bWaiting) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("writing...");
+		}
+		else if (uncommitted > 0) {
+			ImGui::SameLine();
+			ImGui::TextDisabled("%d not in flash", uncommitted);
+		}
+
+		if (ImGui::CollapsingHeader("Tuning Sets")) {
+
+			static std::string chosen;
+			static char setName[64] = "";
+
+			const std::vector<std::string> names = tuningSets.GetNames();
+
+			if (ImGui::BeginCombo("##tuningSet", chosen.empty() ? "None" : chosen.c_str())) {
+				for (const std::string& name : names) {
+					if (ImGui::Selectable(name.c_str(), name == chosen)) {
+						chosen = name;
+						snprintf(setName, sizeof(setName), "%s", name.c_str());
+					}
+				}
+
+				ImGui::EndCombo();
+			}
+
+			const tic::settings* set = tuningSets.Find(chosen);
+
+			static std::string loadError;
+
+			ImGui::BeginDisabled(set == nullptr);
+
+			// one write in flight at a time, the same as Update and Commit to Flash
+			ImGui::BeginDisabled(bWaiting);
+
+			if (ImGui::Button("Load##tuningSet")) {
+				loadError = LoadTuningSet(current, *set) ? "" : chosen + " is for another TIC";
+			}
+
+			ImGui::EndDisabled();
+
+			ImGui::SameLine();
+
+			bool bAnyWaiting = false;
+
+			for (auto& context : contexts) {
+				bAnyWaiting |= context->SettingsReply.valid();
+			}
+
+			ImGui::BeginDisabled(bAnyWaiting);
+
+			// the same set on every TIC, each only sent its runtime fields
+			if (ImGui::Button("Load All##tuningSet")) {
+
+				int skipped = 0;
+
+				for (auto& context : contexts) {
+					if (!LoadTuningSet(*context, *set)) {
+						skipped++;
+					}
+				}
+
+				loadError = skipped ? std::to_string(skipped) + " TICs skipped, " + chosen + " is for another TIC" : "";
+			}
+
+			ImGui::EndDisabled();
+
+			ImGui::SameLine();
+
+			if (ImGui::Button("Delete##tuningSet")) {
+				tuningSets.Remove(chosen);
+				chosen.clear();
+			}
+
+			ImGui::EndDisabled();
+
+			ImGui::InputText("Name##tuningSet", setName, sizeof(setName));
+			ImGui::SameLine();
+
+			if (ImGui::Button("Save##tuningSet") && tuningSets.Save(setName, current.Settings)) {
+				chosen = setName;
+			}
+
+			ImGui::SameLine();
+
+			if (ImGui::Button("Reload##tuningSet")) {
+				tuningSets.Open(tuningSets.GetDirectory());
+			}
+
+			if (!loadError.empty()) {
+				ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", loadError.c_str());
+			}
+
+			// a load leaves the rest of a set for Commit to Flash, which TICs have some waiting
+			for (auto& context : contexts) {
+
+				const int waiting = ChangedFields(context->Stored, context->Settings);
+
+				if (waiting > 0) {
+					ImGui::TextDisabled("%s: %d not in flash", context->Device->get_name().c_str(), waiting);
+				}
+			}
+
+			if (!tuningSets.GetError().empty()) {
+				ImGui::TextColored(ImVec4(1, 0, 0, 1), "%s", tuningSets.GetError().c_str());
+			}
+
+			if (!tuningSets.GetWarnings().empty()) {
+				ImGui::TextWrapped("%s", tuningSets.GetWarnings().c_str());
+			}
 		}
 	}
 
@@ -0,0 +1,260 @@
+#include "tic_command_queue.h"
+
+static double Seconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+bool TicCommandQueue::Changed(const Last& last, uint32_t value)
+{
+	if (last.bKnown && last.Value == value) {
+		SavedCount++;
+		return false;
+	}
+
+	return true;
+}
+
+void TicCommandQueue::ForgetTargets()
+{
+	Position.bKnown = false;
+	Velocity.bKnown = false;
+}
+
+void TicCommandQueue::ForgetSettings()
+{
+	MaxSpeed.bKnown = false;
+	StartingSpeed.bKnown = false;
+	MaxAccel.bKnown = false;
+	MaxDecel.bKnown = false;
+	StepMode.bKnown = false;
+	CurrentLimit.bKnown = false;
+	DecayMode.bKnown = false;
+}
+
+void TicCommandQueue::Sent()
+{
+	SentCount++;
+	LastCommand = Clock::now();
+}
+
+void TicCommandQueue::Sent(Last& last, uint32_t value)
+{
+	// only once it's gone, a transfer that threw leaves it unknown
+	last.bKnown = true;
+	last.Value = value;
+
+	Sent();
+}
+
+void TicCommandQueue::get_variables(TicSample& sample)
+{
+	Inner->get_variables(sample);
+
+	ErrorStatus = sample.ErrorStatus;
+
+	// only on a change, fast reads repeat the state from the last full read so a steady
+	// state is seen many times over. into or out of normal running (a reset, an error
+	// raised or cleared) the TIC may have dropped whatever target it had
+	const bool bNormal = sample.OperationState == TIC_OPERATION_STATE_NORMAL && sample.ErrorStatus == 0;
+
+	if (!bStateKnown || bNormal != bWasNormal) {
+		ForgetTargets();
+	}
+
+	// de-energised by something other than deenergize(), or the first read finding it so
+	if (!bStateKnown || sample.OperationState != LastState) {
+		bDeenergised = sample.OperationState == TIC_OPERATION_STATE_DEENERGIZED;
+	}
+
+	bStateKnown = true;
+	bWasNormal = bNormal;
+	LastState = sample.OperationState;
+
+	const Clock::time_point now = Clock::now();
+
+	if (Seconds(now - LastCommand) >= KeepAlive) {
+		reset_command_timeout();
+	}
+
+	const double window = Seconds(now - RateWindow);
+
+	if (window >= 1.0) {
+		SentRate.store(SentCount / window);
+		SavedRate.store(SavedCount / window);
+
+		SentCount = 0;
+		SavedCount = 0;
+		RateWindow = now;
+	}
+}
+
+void TicCommandQueue::set_target_position(int32_t position)
+{
+	// nothing to move, it goes once energised
+	if (bDeenergised) {
+		SavedCount++;
+		return;
+	}
+
+	if (!Changed(Position, (uint32_t)position)) {
+		return;
+	}
+
+	Velocity.bKnown = false;
+
+	Inner->set_target_position(position);
+	Sent(Position, (uint32_t)position);
+}
+
+void TicCommandQueue::set_target_velocity(int32_t velocity)
+{
+	if (bDeenergised) {
+		SavedCount++;
+		return;
+	}
+
+	if (!Changed(Velocity, (uint32_t)velocity)) {
+		return;
+	}
+
+	Position.bKnown = false;
+
+	Inner->set_target_velocity(velocity);
+	Sent(Velocity, (uint32_t)velocity);
+}
+
+void TicCommandQueue::halt_and_hold()
+{
+	ForgetTargets();
+
+	Inner->halt_and_hold();
+	Sent();
+}
+
+void TicCommandQueue::energize()
+{
+	ForgetTargets();
+	bSafeStartPending = true;
+
+	Inner->energize();
+	Sent();
+
+	bDeenergised = false;
+}
+
+void TicCommandQueue::deenergize()
+{
+	ForgetTargets();
+
+	Inner->deenergize();
+	Sent();
+
+	bDeenergised = true;
+}
+
+void TicCommandQueue::exit_safe_start()
+{
+	const bool bViolation = (ErrorStatus & (1 << TIC_ERROR_SAFE_START_VIOLATION)) != 0;
+
+	if (!bSafeStartPending && (!bViolation || Seconds(Clock::now() - LastSafeStart) < SafeStartRetry)) {
+		SavedCount++;
+		return;
+	}
+
+	Inner->exit_safe_start();
+	Sent();
+
+	bSafeStartPending = false;
+	LastSafeStart = Clock::now();
+
+	// anything sent while it was in safe start was ignored
+	ForgetTargets();
+}
+
+void TicCommandQueue::reset_command_timeout()
+{
+	Inner->reset_command_timeout();
+	Sent();
+}
+
+void TicCommandQueue::set_max_speed(uint32_t max_speed)
+{
+	if (Changed(MaxSpeed, max_speed)) {
+		Inner->set_max_speed(max_speed);
+		Sent(MaxSpeed, max_speed);
+	}
+}
+
+void TicCommandQueue::set_starting_speed(uint32_t starting_speed)
+{
+	if (Changed(StartingSpeed, starting_speed)) {
+		Inner->set_starting_speed(starting_speed);
+		Sent(StartingSpeed, starting_speed);
+	}
+}
+
+void TicCommandQueue::set_max_accel(uint32_t max_accel)
+{
+	if (Changed(MaxAccel, max_accel)) {
+		Inner->set_max_accel(max_accel);
+		Sent(MaxAccel, max_accel);
+	}
+}
+
+void TicCommandQueue::set_max_decel(uint32_t max_decel)
+{
+	if (Changed(MaxDecel, max_decel)) {
+		Inner->set_max_decel(max_decel);
+		Sent(MaxDecel, max_decel);
+	}
+}
+
+void TicCommandQueue::set_step_mode(uint8_t step_mode)
+{
+	if (Changed(StepMode, step_mode)) {
+		Inner->set_step_mode(step_mode);
+		Sent(StepMode, step_mode);
+	}
+}
+
+void TicCommandQueue::set_current_limit(uint32_t current_limit)
+{
+	if (Changed(CurrentLimit, current_limit)) {
+		Inner->set_current_limit(current_limit);
+		Sent(CurrentLimit, current_limit);
+	}
+}
+
+void TicCommandQueue::set_decay_mode(uint8_t decay_mode)
+{
+	if (Changed(DecayMode, decay_mode)) {
+		Inner->set_decay_mode(decay_mode);
+		Sent(DecayMode, decay_mode);
+	}
+}
+
+void TicCommandQueue::set_settings(const tic::settings& settings)
+{
+	ForgetSettings();
+
+	Inner->set_settings(settings);
+	Sent();
+}
+
+void TicCommandQueue::set_setting_byte(uint8_t address, uint8_t value)
+{
+	// stored only, nothing live changes until reinitialize
+	Inner->set_setting_byte(address, value);
+	Sent();
+}
+
+void TicCommandQueue::reinitialize()
+{
+	ForgetTargets();
+	ForgetSettings();
+	bSafeStartPending = true;
+
+	Inner->reinitialize();
+	Sent();
+}
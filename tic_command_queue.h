@@ -0,0 +1,131 @@
+#pragma once
+
+// sits in front of a TicDevice and drops the USB transfers that wouldn't change anything.
+// a command identical to the last one sent is only sent again once the TIC may have
+// forgotten it (energise, entering or leaving an error, reinitialise), targets aren't sent
+// at all while it's de-energised, exit_safe_start only goes when the TIC
+// is actually in safe start, and reset_command_timeout keeps the TIC's command timeout
+// fed in place of the per-poll commands that used to. target updates are already
+// coalesced to the newest per control tick by the acquisition thread reading one target
+// per poll, this drops the repeats between them
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "tic_device.h"
+
+class TicCommandQueue : public TicDevice {
+
+public:
+
+	// longest the TIC goes without a command, well inside its default 1s command timeout
+	static constexpr double KeepAlive = 0.25;
+
+	// while a sample still shows safe start, exit_safe_start is repeated no faster than this.
+	// fast reads carry the error bits from the last full read, so they can be stale
+	static constexpr double SafeStartRetry = 0.05;
+
+	explicit TicCommandQueue(std::unique_ptr<TicDevice> device) : Inner(std::move(device)) {}
+
+	// the device commands go to
+	TicDevice& GetDevice() { return *Inner; }
+
+	// transfers sent and dropped per second over the last second
+	double GetSentRate() const { return SentRate.load(); }
+	double GetSavedRate() const { return SavedRate.load(); }
+
+	std::chrono::steady_clock::time_point Now() const override { return Inner->Now(); }
+
+	std::string get_name() const override { return Inner->get_name(); }
+
+	void get_variables(TicSample& sample) override;
+
+	void set_target_position(int32_t position) override;
+	void set_target_velocity(int32_t velocity) override;
+	void halt_and_hold() override;
+
+	void energize() override;
+	void deenergize() override;
+
+	// only when the last sample showed a safe start violation, or after energize
+	void exit_safe_start() override;
+	void reset_command_timeout() override;
+
+	void set_max_speed(uint32_t max_speed) override;
+	void set_starting_speed(uint32_t starting_speed) override;
+	void set_max_accel(uint32_t max_accel) override;
+	void set_max_decel(uint32_t max_decel) override;
+	void set_step_mode(uint8_t step_mode) override;
+	void set_current_limit(uint32_t current_limit) override;
+	void set_decay_mode(uint8_t decay_mode) override;
+
+	tic::settings get_settings() override { return Inner->get_settings(); }
+	void set_settings(const tic::settings& settings) override;
+	void set_setting_byte(uint8_t address, uint8_t value) override;
+	bool has_setting_bytes() const override { return Inner->has_setting_bytes(); }
+	void reinitialize() override;
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	// last value sent for one command, Known is cleared when the TIC may have lost it
+	struct Last {
+		bool bKnown = false;
+		uint32_t Value = 0;
+	};
+
+	// true if value needs sending, false counts a saved transfer
+	bool Changed(const Last& last, uint32_t value);
+
+	// targets go again after anything that can make the TIC drop them
+	void ForgetTargets();
+
+	// the runtime settings go again after the settings are rewritten
+	void ForgetSettings();
+
+	void Sent();
+	void Sent(Last& last, uint32_t value);
+
+	std::unique_ptr<TicDevice> Inner;
+
+	// only one of the two is Known, the TIC is in position or velocity mode
+	Last Position;
+	Last Velocity;
+
+	Last MaxSpeed;
+	Last StartingSpeed;
+	Last MaxAccel;
+	Last MaxDecel;
+	Last StepMode;
+	Last CurrentLimit;
+	Last DecayMode;
+
+	// error bits from the newest sample
+	uint16_t ErrorStatus = 0;
+
+	// state as of the last sample, targets are forgotten on a change rather than every poll
+	bool bStateKnown = false;
+	bool bWasNormal = false;
+	uint8_t LastState = 0;
+
+	// targets aren't sent while de-energised, energize() forgets them so they go after
+	bool bDeenergised = false;
+
+	// a TIC starts in safe start, and energize puts it back there
+	bool bSafeStartPending = true;
+
+	Clock::time_point LastCommand = Clock::now();
+	Clock::time_point LastSafeStart;
+
+	// counted under the device lock, rates published once a second
+	uint64_t SentCount = 0;
+	uint64_t SavedCount = 0;
+	Clock::time_point RateWindow = Clock::now();
+
+	std::atomic<double> SentRate{ 0 };
+	std::atomic<double> SavedRate{ 0 };
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+// everything ticTune keeps for one TIC, so several can be driven and plotted at once.
+// each has its own acquisition thread, so USB round-trips to one never hold up another
+
+#include <cstdint>
+#include <future>
+#include <memory>
+
+#include "acquisition.h"
+#include "recorder.h"
+#include "telemetry.h"
+#include "tic_command_queue.h"
+#include "tic_device.h"
+#include "tracking.h"
+
+struct TicContext {
+
+	// device goes behind a command queue, so everything sent to it drops repeats
+	explicit TicContext(std::unique_ptr<TicDevice> device)
+	{
+		auto queue = std::make_unique<TicCommandQueue>(std::move(device));
+
+		Queue = queue.get();
+		Device = std::move(queue);
+	}
+
+	TicContext(const TicContext&) = delete;
+	TicContext& operator=(const TicContext&) = delete;
+
+	// a real TIC over USB or the simulator, through Queue
+	std::unique_ptr<TicDevice> Device;
+	TicCommandQueue* Queue = nullptr;
+	tic::settings Settings;
+
+	// what the TIC has stored as of the last read or write, Settings is written as the difference from it
+	tic::settings Stored;
+
+	// Stored after a write or refresh posted to Acq, valid until the GUI takes it.
+	// a refresh also replaces Settings
+	std::future<tic::settings> SettingsReply;
+	bool bRefreshing = false;
+
+	// polls Device on its own thread, anything else talking to Device takes Acq.LockDevice() first
+	Acquisition Acq;
+
+	// binary log of every sample Acq polls
+	Recorder Rec;
+
+	TelemetryStore Telemetry;
+
+	// how well position follows target, fed every polled sample
+	TrackingAnalytics Tracking;
+
+	// newest sample drained from Acq
+	TicSample Sample = {};
+
+	// index into ProfileLibrary() Acq is stepping through, -1 for none
+	int Profile = -1;
+
+	// run profiles with set_target_velocity rather than set_target_position
+	bool bVelocityControl = false;
+
+	// position asked for, from the slider or read back from the running profile
+	int32_t Target = 0;
+
+	bool bEnabled = false;
+
+	// part of the next synchronised move
+	bool bSync = true;
+
+	// invert motor direction
+	bool bInvertMotor = false;
+
+	// flags if any settings were changed
+	bool bChanged = false;
+
+	// settings for stepper motor
+	int iMaxSpeed			= 28400000;
+	int iStartingSpeed		= 0;
+	int iMaxAcceleration	= 280000;
+	int iMaxDeceleration	= 280000;
+	int step_mode			= 0;
+	int decay_mode			= 0;
+	int current_limit		= 0;
+};
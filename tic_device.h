@@ -0,0 +1,392 @@
+#pragma once
+
+// the subset of tic::handle ticTune drives, so a real TIC over USB and the
+// simulator can sit behind the same calls
+
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "tic/tic.hpp"
+#include "tic/tic_protocol.h"
+#include "tic_usb_bytes.h"
+
+// microsteps per full step at a TIC_STEP_MODE_*, not 1 << mode from MICROSTEP2_100P on
+inline uint32_t Microsteps(uint8_t stepMode)
+{
+	static constexpr uint32_t PerStep[] = { 1, 2, 4, 8, 16, 32, 2, 64, 128, 256 };
+
+	return (stepMode < sizeof(PerStep) / sizeof(PerStep[0])) ? PerStep[stepMode] : 1;
+}
+
+// plain copy of the variables we care about, safe to pass between threads
+struct TicSample {
+
+	// seconds since the acquisition thread started
+	double Time;
+
+	// position requested by the GUI when this sample was taken
+	int32_t RequestPosition;
+
+	int32_t TargetPosition;
+	int32_t CurrentPosition;
+	int32_t CurrentVelocity;
+
+	uint32_t MaxSpeed;
+	uint32_t StartingSpeed;
+	uint32_t MaxAccel;
+	uint32_t MaxDecel;
+
+	// milli volts
+	uint32_t VinVoltage;
+
+	// milli amps
+	uint32_t CurrentLimit;
+
+	uint32_t ErrorsOccurred;
+	uint16_t ErrorStatus;
+
+	uint8_t OperationState;
+	uint8_t StepMode;
+};
+
+// TicSample fields that can be read on their own
+enum class TicField : uint8_t {
+	OperationState,
+	ErrorStatus,
+	ErrorsOccurred,
+	TargetPosition,
+	StartingSpeed,
+	MaxSpeed,
+	MaxDecel,
+	MaxAccel,
+	CurrentPosition,
+	CurrentVelocity,
+	VinVoltage,
+	StepMode,
+	CurrentLimit,
+	Count
+};
+
+// a few TicSample fields read straight out of the TIC's variables block. the span from
+// the lowest to the highest field comes back in one get variable transfer and is decoded
+// in place, no tic::variables and no allocation
+class TicVariableSubset {
+
+public:
+
+	// enough for any span of the fields above
+	static constexpr int MaxLength = TIC_VAR_CURRENT_LIMIT + 1;
+
+	TicVariableSubset() {}
+
+	TicVariableSubset(std::initializer_list<TicField> fields)
+	{
+		for (TicField field : fields) {
+			Add(field);
+		}
+	}
+
+	// every field, a whole TicSample in one transfer. product is needed to turn the
+	// current limit code into milliamps
+	static TicVariableSubset All(uint8_t product)
+	{
+		TicVariableSubset subset;
+
+		for (int field = 0; field < (int)TicField::Count; field++) {
+			subset.Add((TicField)field);
+		}
+
+		subset.Product = product;
+
+		return subset;
+	}
+
+	void Add(TicField field)
+	{
+		const Layout& layout = Layouts[(int)field];
+
+		if (Mask == 0 || layout.Offset < First) {
+			First = layout.Offset;
+		}
+
+		if (Mask == 0 || layout.Offset + layout.Size > End) {
+			End = layout.Offset + layout.Size;
+		}
+
+		Mask |= 1u << (int)field;
+	}
+
+	bool Empty() const { return Mask == 0; }
+
+	// what to ask the TIC for
+	uint8_t Offset() const { return First; }
+	uint8_t Length() const { return (uint8_t)(End - First); }
+
+	// buffer holds Length() bytes read from Offset(), fields not in the subset are left alone
+	void Decode(const uint8_t* buffer, TicSample& sample) const
+	{
+		for (int field = 0; field < (int)TicField::Count; field++) {
+
+			if (!(Mask & (1u << field))) {
+				continue;
+			}
+
+			const uint32_t value = Read(buffer, Layouts[field]);
+
+			switch ((TicField)field) {
+			case TicField::OperationState:	sample.OperationState	= (uint8_t)value;	break;
+			case TicField::ErrorStatus:		sample.ErrorStatus		= (uint16_t)value;	break;
+			case TicField::ErrorsOccurred:	sample.ErrorsOccurred	= value;			break;
+			case TicField::TargetPosition:	sample.TargetPosition	= (int32_t)value;	break;
+			case TicField::StartingSpeed:	sample.StartingSpeed	= value;			break;
+			case TicField::MaxSpeed:		sample.MaxSpeed			= value;			break;
+			case TicField::MaxDecel:		sample.MaxDecel			= value;			break;
+			case TicField::MaxAccel:		sample.MaxAccel			= value;			break;
+			case TicField::CurrentPosition:	sample.CurrentPosition	= (int32_t)value;	break;
+			case TicField::CurrentVelocity:	sample.CurrentVelocity	= (int32_t)value;	break;
+			case TicField::VinVoltage:		sample.VinVoltage		= value;			break;
+			case TicField::StepMode:		sample.StepMode			= (uint8_t)value;	break;
+			case TicField::CurrentLimit:	sample.CurrentLimit		= tic_current_limit_code_to_ma(Product, (uint8_t)value);	break;
+			default:																	break;
+			}
+		}
+	}
+
+private:
+
+	struct Layout {
+		uint8_t Offset;
+		uint8_t Size;
+	};
+
+	// same order as TicField
+	static constexpr Layout Layouts[(int)TicField::Count] = {
+		{ TIC_VAR_OPERATION_STATE, 1 },
+		{ TIC_VAR_ERROR_STATUS, 2 },
+		{ TIC_VAR_ERRORS_OCCURRED, 4 },
+		{ TIC_VAR_TARGET_POSITION, 4 },
+		{ TIC_VAR_STARTING_SPEED, 4 },
+		{ TIC_VAR_MAX_SPEED, 4 },
+		{ TIC_VAR_MAX_DECEL, 4 },
+		{ TIC_VAR_MAX_ACCEL, 4 },
+		{ TIC_VAR_CURRENT_POSITION, 4 },
+		{ TIC_VAR_CURRENT_VELOCITY, 4 },
+		{ TIC_VAR_VIN_VOLTAGE, 2 },
+		{ TIC_VAR_STEP_MODE, 1 },
+		{ TIC_VAR_CURRENT_LIMIT, 1 },
+	};
+
+	// little endian, widened to 32 bits
+	uint32_t Read(const uint8_t* buffer, const Layout& layout) const
+	{
+		const uint8_t* at = buffer + (layout.Offset - First);
+
+		uint32_t value = 0;
+
+		for (int i = layout.Size - 1; i >= 0; i--) {
+			value = (value << 8) | at[i];
+		}
+
+		return value;
+	}
+
+	uint32_t Mask = 0;
+	int First = 0;
+	int End = 0;
+
+	uint8_t Product = 0;
+};
+
+// names follow tic::handle so call sites read the same for either implementation
+class TicDevice {
+
+public:
+
+	virtual ~TicDevice() {}
+
+	// the clock the TIC's time runs on, safe from any thread. the steady clock for a real
+	// TIC, a simulator faster than real time has its own. sample times, profile tables and
+	// trainer phases are all on it
+	virtual std::chrono::steady_clock::time_point Now() const { return std::chrono::steady_clock::now(); }
+
+	virtual std::string get_name() const = 0;
+
+	virtual void get_variables(TicSample& sample) = 0;
+
+	virtual void set_target_position(int32_t position) = 0;
+	virtual void set_target_velocity(int32_t velocity) = 0;
+	virtual void halt_and_hold() = 0;
+
+	virtual void energize() = 0;
+	virtual void deenergize() = 0;
+	virtual void exit_safe_start() = 0;
+	virtual void reset_command_timeout() = 0;
+
+	virtual void set_max_speed(uint32_t max_speed) = 0;
+	virtual void set_starting_speed(uint32_t starting_speed) = 0;
+	virtual void set_max_accel(uint32_t max_accel) = 0;
+	virtual void set_max_decel(uint32_t max_decel) = 0;
+	virtual void set_step_mode(uint8_t step_mode) = 0;
+	virtual void set_current_limit(uint32_t current_limit) = 0;
+	virtual void set_decay_mode(uint8_t decay_mode) = 0;
+
+	virtual tic::settings get_settings() = 0;
+	virtual void set_settings(const tic::settings& settings) = 0;
+
+	// one byte of the stored settings at a TIC_SETTING_* address, takes effect on reinitialize()
+	virtual void set_setting_byte(uint8_t address, uint8_t value) = 0;
+
+	// false if set_setting_byte() can't be used, settings then go as a whole set_settings()
+	virtual bool has_setting_bytes() const = 0;
+
+	virtual void reinitialize() = 0;
+};
+
+// a physical TIC through libtic
+class UsbTicDevice : public TicDevice {
+
+public:
+
+	explicit UsbTicDevice(const tic::device& device) :
+		Handle(device), Name(device.get_short_name() + " " + device.get_serial_number()), FullRead(TicVariableSubset::All(device.get_product()))
+	{
+#ifdef TICTUNE_USB_BYTES
+		// without it everything still works, a poll is a whole tic::variables read
+		try {
+			Bytes = std::make_unique<TicUsbBytes>(device);
+		}
+		catch (const std::exception& error) {
+			std::cerr << Name << ": no single transfers, " << error.what() << std::endl;
+		}
+#endif
+	}
+
+	tic::handle& GetHandle() { return Handle; }
+
+	// read only these fields on most polls, with a full read every fullEvery polls
+	// for the rest. an empty subset always does the full read.
+	// needs TICTUNE_USB_BYTES, without it every read is a full tic::variables one
+	void SetFastRead(const TicVariableSubset& subset, int fullEvery)
+	{
+		FastRead = subset;
+		FullReadEvery = fullEvery;
+		SinceFullRead = 0;
+	}
+
+	std::string get_name() const override { return Name; }
+
+	void get_variables(TicSample& sample) override
+	{
+#ifdef TICTUNE_USB_BYTES
+		if (Bytes) {
+			ReadBytes(sample);
+			return;
+		}
+#endif
+
+		tic::variables vars = Handle.get_variables();
+
+		sample.TargetPosition	= vars.get_target_position();
+		sample.CurrentPosition	= vars.get_current_position();
+		sample.CurrentVelocity	= vars.get_current_velocity();
+		sample.MaxSpeed			= vars.get_max_speed();
+		sample.StartingSpeed	= vars.get_starting_speed();
+		sample.MaxAccel			= vars.get_max_accel();
+		sample.MaxDecel			= vars.get_max_decel();
+		sample.VinVoltage		= vars.get_vin_voltage();
+		sample.CurrentLimit		= vars.get_current_limit();
+		sample.ErrorsOccurred	= vars.get_errors_occurred();
+		sample.ErrorStatus		= vars.get_error_status();
+		sample.OperationState	= vars.get_operation_state();
+		sample.StepMode			= vars.get_step_mode();
+	}
+
+	void set_target_position(int32_t position) override { Handle.set_target_position(position); }
+	void set_target_velocity(int32_t velocity) override { Handle.set_target_velocity(velocity); }
+	void halt_and_hold() override { Handle.halt_and_hold(); }
+
+	void energize() override { Handle.energize(); }
+	void deenergize() override { Handle.deenergize(); }
+	void exit_safe_start() override { Handle.exit_safe_start(); }
+	void reset_command_timeout() override { Handle.reset_command_timeout(); }
+
+	void set_max_speed(uint32_t max_speed) override { Handle.set_max_speed(max_speed); }
+	void set_starting_speed(uint32_t starting_speed) override { Handle.set_starting_speed(starting_speed); }
+	void set_max_accel(uint32_t max_accel) override { Handle.set_max_accel(max_accel); }
+	void set_max_decel(uint32_t max_decel) override { Handle.set_max_decel(max_decel); }
+	void set_step_mode(uint8_t step_mode) override { Handle.set_step_mode(step_mode); }
+	void set_current_limit(uint32_t current_limit) override { Handle.set_current_limit(current_limit); }
+	void set_decay_mode(uint8_t decay_mode) override { Handle.set_decay_mode(decay_mode); }
+
+	tic::settings get_settings() override { return Handle.get_settings(); }
+	void set_settings(const tic::settings& settings) override { Handle.set_settings(settings); }
+
+	// needs the handle TICTUNE_USB_BYTES opens, WriteSettings() doesn't call it without
+	void set_setting_byte(uint8_t address, uint8_t value) override
+	{
+#ifdef TICTUNE_USB_BYTES
+		if (Bytes) {
+			Bytes->SetSetting(address, value);
+			return;
+		}
+#endif
+		(void)address;
+		(void)value;
+		throw std::runtime_error("set_setting_byte needs single transfers, " + Name + " has none");
+	}
+
+	bool has_setting_bytes() const override
+	{
+#ifdef TICTUNE_USB_BYTES
+		return Bytes != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	void reinitialize() override { Handle.reinitialize(); }
+
+private:
+
+	tic::handle Handle;
+	std::string Name;
+
+	// position, velocity and VIN are one 19 byte transfer instead of the whole block
+	TicVariableSubset FastRead = { TicField::CurrentPosition, TicField::CurrentVelocity, TicField::VinVoltage };
+	TicVariableSubset FullRead;
+	int FullReadEvery = 100;
+	int SinceFullRead = 0;
+
+	TicSample Last = {};
+
+#ifdef TICTUNE_USB_BYTES
+	// straight into the sample either way, tic::variables would malloc and free each poll
+	void ReadBytes(TicSample& sample)
+	{
+		const bool bFast = !FastRead.Empty() && ++SinceFullRead < FullReadEvery;
+		const TicVariableSubset& subset = bFast ? FastRead : FullRead;
+
+		uint8_t buffer[TicVariableSubset::MaxLength];
+
+		Bytes->GetVariables(subset.Offset(), subset.Length(), buffer);
+
+		if (!bFast) {
+			SinceFullRead = 0;
+		}
+
+		// on a fast read everything outside the subset is as of the last full read
+		sample = Last;
+		subset.Decode(buffer, sample);
+
+		Last = sample;
+	}
+
+	// nullptr if the second handle wouldn't open
+	std::unique_ptr<TicUsbBytes> Bytes;
+#endif
+};
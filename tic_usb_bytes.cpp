@@ -0,0 +1,47 @@
+#include "tic_usb_bytes.h"
+
+#ifdef TICTUNE_USB_BYTES
+
+#include <stdexcept>
+#include <string>
+
+#include "tic/tic_protocol.h"
+
+// vendor requests to the device, in and out
+static constexpr uint8_t RequestIn = 0xC0;
+static constexpr uint8_t RequestOut = 0x40;
+
+libusbp::device TicUsbBytes::FindDevice(const tic::device& device)
+{
+	const std::string id = device.get_os_id();
+
+	for (const libusbp::device& candidate : libusbp::list_connected_devices()) {
+		if (candidate.get_os_id() == id) {
+			return candidate;
+		}
+	}
+
+	throw std::runtime_error("can't find " + device.get_serial_number() + " over USB");
+}
+
+// the TIC's native interface is interface 0 of a non-composite device, as libtic opens it
+TicUsbBytes::TicUsbBytes(const tic::device& device) :
+	Handle(libusbp::generic_interface(FindDevice(device), 0, false)) {}
+
+void TicUsbBytes::GetVariables(uint8_t offset, uint8_t length, uint8_t* buffer)
+{
+	size_t transferred = 0;
+
+	Handle.control_transfer(RequestIn, TIC_CMD_GET_VARIABLE, 0, offset, buffer, length, &transferred);
+
+	if (transferred != length) {
+		throw std::runtime_error("read " + std::to_string(transferred) + " of " + std::to_string(length) + " variable bytes");
+	}
+}
+
+void TicUsbBytes::SetSetting(uint8_t address, uint8_t value)
+{
+	Handle.control_transfer(RequestOut, TIC_CMD_SET_SETTING, value, address);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+// single control transfers to a TIC that libtic has no call for, a slice of the variables
+// block or one byte of the stored settings. they go through a libusbp handle of our own on
+// the TIC's native interface, found by the OS id tic::device reports, so nothing of
+// libtic's internals is needed. only the CMake build has the libusbp headers, it defines
+// TICTUNE_USB_BYTES
+
+#ifdef TICTUNE_USB_BYTES
+
+#include <cstdint>
+
+#include <libusbp.hpp>
+
+#include "tic/tic.hpp"
+
+class TicUsbBytes {
+
+public:
+
+	// throws if the TIC has gone or its interface won't open a second time (WinUSB can refuse)
+	explicit TicUsbBytes(const tic::device& device);
+
+	// length bytes of the variables block from offset, a TIC_VAR_* in tic_protocol.h.
+	// one get variable transfer, nothing allocated
+	void GetVariables(uint8_t offset, uint8_t length, uint8_t* buffer);
+
+	// one byte of the stored settings at address, a TIC_SETTING_*. nothing is checked or
+	// fixed, and like set_settings it takes effect after reinitialize
+	void SetSetting(uint8_t address, uint8_t value);
+
+private:
+
+	static libusbp::device FindDevice(const tic::device& device);
+
+	libusbp::generic_handle Handle;
+};
+
+#endif
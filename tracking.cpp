@@ -0,0 +1,387 @@
+#include "tracking.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+TrackingAnalytics::TrackingAnalytics() : ErrorStats(Window), SquareStats(Window)
+{
+	Times.resize(RingSize);
+	Targets.resize(RingSize);
+	Positions.resize(RingSize);
+	Errors.resize(RingSize);
+
+	Cross.resize(MaxLag + 1);
+	Scores.resize(MaxLag + 1);
+}
+
+void TrackingAnalytics::Reset()
+{
+	Count = 0;
+	SinceResync = 0;
+	Reference = 0;
+
+	SumTarget = 0;
+	SumPosition = 0;
+	SumTarget2 = 0;
+	SumPosition2 = 0;
+
+	for (double& cross : Cross) {
+		cross = 0;
+	}
+
+	LagCount = UINT64_MAX;
+
+	ErrorStats.Reset();
+	SquareStats.Reset();
+
+	bMoving = false;
+	bMeasuring = false;
+	Direction = 0;
+	Current = {};
+
+	Finished.clear();
+
+	MovesSeen = 0;
+	SettledCount = 0;
+	SettlingSum = 0;
+	OvershootSum = 0;
+	OvershootMax = 0;
+}
+
+void TrackingAnalytics::Add(double time, int32_t target, int32_t position)
+{
+	if (Count == 0) {
+		Reference = target;
+		LastTarget = target;
+		HeldSince = time;
+	}
+
+	// the oldest sample leaves the window before the new one goes in
+	if (Count >= Window) {
+
+		const uint64_t old = Count - Window;
+		const size_t slot = At(old);
+
+		ErrorStats.Evict(Errors[slot]);
+		SquareStats.Evict(Errors[slot] * Errors[slot]);
+
+		SumTarget -= Targets[slot];
+		SumPosition -= Positions[slot];
+		SumTarget2 -= Targets[slot] * Targets[slot];
+		SumPosition2 -= Positions[slot] * Positions[slot];
+
+		for (size_t lag = 0; lag <= MaxLag && lag <= old; lag++) {
+			Cross[lag] -= Targets[At(old - lag)] * Positions[slot];
+		}
+	}
+
+	const size_t slot = At(Count);
+
+	Times[slot] = time;
+	Targets[slot] = target - Reference;
+	Positions[slot] = position - Reference;
+	Errors[slot] = (double)target - position;
+
+	ErrorStats.Push(Errors[slot]);
+	SquareStats.Push(Errors[slot] * Errors[slot]);
+
+	SumTarget += Targets[slot];
+	SumPosition += Positions[slot];
+	SumTarget2 += Targets[slot] * Targets[slot];
+	SumPosition2 += Positions[slot] * Positions[slot];
+
+	for (size_t lag = 0; lag <= MaxLag && lag <= Count; lag++) {
+		Cross[lag] += Targets[At(Count - lag)] * Positions[slot];
+	}
+
+	Count++;
+
+	if (++SinceResync >= Window) {
+		Resync();
+	}
+
+	UpdateMove(time, target, position);
+}
+
+void TrackingAnalytics::Resync()
+{
+	SinceResync = 0;
+
+	const uint64_t first = (Count > Window) ? Count - Window : 0;
+
+	double errors = 0, squares = 0;
+
+	SumTarget = 0;
+	SumPosition = 0;
+	SumTarget2 = 0;
+	SumPosition2 = 0;
+
+	for (double& cross : Cross) {
+		cross = 0;
+	}
+
+	for (uint64_t i = first; i < Count; i++) {
+
+		const size_t slot = At(i);
+
+		errors += Errors[slot];
+		squares += Errors[slot] * Errors[slot];
+
+		SumTarget += Targets[slot];
+		SumPosition += Positions[slot];
+		SumTarget2 += Targets[slot] * Targets[slot];
+		SumPosition2 += Positions[slot] * Positions[slot];
+
+		for (size_t lag = 0; lag <= MaxLag && lag <= i; lag++) {
+			Cross[lag] += Targets[At(i - lag)] * Positions[slot];
+		}
+	}
+
+	ErrorStats.SetSum(errors);
+	SquareStats.SetSum(squares);
+}
+
+double TrackingAnalytics::Rms() const
+{
+	return sqrt(SquareStats.Avg() > 0 ? SquareStats.Avg() : 0);
+}
+
+double TrackingAnalytics::Peak() const
+{
+	if (Count == 0) {
+		return 0;
+	}
+
+	return fabs(ErrorStats.Min()) > fabs(ErrorStats.Max()) ? fabs(ErrorStats.Min()) : fabs(ErrorStats.Max());
+}
+
+void TrackingAnalytics::FindLag(double& lag, double& correlation) const
+{
+	// once per sample however often it's asked for
+	if (LagCount == Count) {
+		lag = CachedLag;
+		correlation = CachedCorrelation;
+		return;
+	}
+
+	LagCount = Count;
+	CachedLag = lag = 0;
+	CachedCorrelation = correlation = 0;
+
+	const uint64_t first = (Count > Window) ? Count - Window : 0;
+
+	if (Count - first < 2) {
+		return;
+	}
+
+	// sums over the samples paired at each lag, slid along one lag at a time. position
+	// uses samples first..Count-1, target the same shifted back by the lag
+	double sumTarget = SumTarget, sumTarget2 = SumTarget2;
+	double sumPosition = SumPosition, sumPosition2 = SumPosition2;
+
+	std::vector<double>& scores = Scores;
+
+	size_t lags = 0;
+
+	for (size_t k = 0; k <= MaxLag; k++) {
+
+		if (k > 0) {
+
+			const double dropped = Targets[At(Count - k)];
+
+			sumTarget -= dropped;
+			sumTarget2 -= dropped * dropped;
+
+			if (k <= first) {
+				const double added = Targets[At(first - k)];
+
+				sumTarget += added;
+				sumTarget2 += added * added;
+			}
+			else {
+				// early on there's nothing before the window, position gives up its oldest instead
+				const double oldest = Positions[At(k - 1)];
+
+				sumPosition -= oldest;
+				sumPosition2 -= oldest * oldest;
+			}
+		}
+
+		const double n = (double)(Count - (k > first ? k : first));
+
+		if (n < 2) {
+			break;
+		}
+
+		const double meanTarget = sumTarget / n;
+		const double meanPosition = sumPosition / n;
+
+		const double spread = sqrt((sumTarget2 / n - meanTarget * meanTarget) * (sumPosition2 / n - meanPosition * meanPosition));
+
+		// nothing moving, there's no lag to find
+		scores[k] = (spread > 1e-9) ? (Cross[k] / n - meanTarget * meanPosition) / spread : 0;
+
+		lags = k;
+	}
+
+	size_t best = 0;
+
+	for (size_t k = 1; k <= lags; k++) {
+		if (scores[k] > scores[best]) {
+			best = k;
+		}
+	}
+
+	lag = (double)best;
+	correlation = scores[best];
+
+	// parabola through the peak and its neighbours for a lag between samples
+	if (best > 0 && best < lags) {
+
+		const double a = scores[best - 1], b = scores[best], c = scores[best + 1];
+		const double denominator = a - 2.0 * b + c;
+
+		if (denominator < 0) {
+			lag += 0.5 * (a - c) / denominator;
+		}
+	}
+
+	CachedLag = lag;
+	CachedCorrelation = correlation;
+}
+
+double TrackingAnalytics::Lag() const
+{
+	double lag, correlation;
+
+	FindLag(lag, correlation);
+
+	const uint64_t n = Count < Window ? Count : Window;
+
+	if (n < 2) {
+		return 0;
+	}
+
+	// samples to seconds at the window's average spacing
+	const double span = Times[At(Count - 1)] - Times[At(Count - n)];
+
+	return lag * span / (n - 1);
+}
+
+double TrackingAnalytics::Correlation() const
+{
+	double lag, correlation;
+
+	FindLag(lag, correlation);
+
+	return correlation;
+}
+
+void TrackingAnalytics::UpdateMove(double time, int32_t target, int32_t position)
+{
+	if (target != LastTarget) {
+
+		// a new move once the last one's target has held
+		if (!bMoving) {
+
+			if (bMeasuring) {
+				FinishMove();
+			}
+
+			Current = {};
+			Current.Start = time;
+			Current.From = LastTarget;
+			Current.Settling = -1;
+
+			Direction = (target > LastTarget) ? 1 : -1;
+
+			bMoving = true;
+		}
+
+		Current.To = target;
+
+		LastTarget = target;
+		HeldSince = time;
+	}
+
+	if (bMoving && time - HeldSince >= HoldTime) {
+		bMoving = false;
+		bMeasuring = true;
+	}
+
+	if (!bMeasuring) {
+		return;
+	}
+
+	const double overshoot = Direction * ((double)position - Current.To);
+
+	if (overshoot > Current.Overshoot) {
+		Current.Overshoot = overshoot;
+	}
+
+	const double distance = fabs((double)Current.To - Current.From);
+	const double band = (SettleBand * distance > SettleSteps) ? SettleBand * distance : SettleSteps;
+
+	if (fabs((double)position - Current.To) > band) {
+		Current.Settling = -1;
+	}
+	else if (Current.Settling < 0) {
+		Current.Settling = time - Current.Start;
+	}
+}
+
+void TrackingAnalytics::FinishMove()
+{
+	bMeasuring = false;
+
+	MovesSeen++;
+
+	OvershootSum += Current.Overshoot;
+
+	if (Current.Overshoot > OvershootMax) {
+		OvershootMax = Current.Overshoot;
+	}
+
+	if (Current.Settling >= 0) {
+		SettledCount++;
+		SettlingSum += Current.Settling;
+	}
+
+	Finished.push_back(Current);
+
+	if (Finished.size() > MaxMoves) {
+		Finished.pop_front();
+	}
+}
+
+bool TrackingAnalytics::Export(const std::string& path) const
+{
+	FILE* file = std::fopen(path.c_str(), "w");
+
+	if (!file) {
+		return false;
+	}
+
+	double lag, correlation;
+
+	FindLag(lag, correlation);
+
+	std::fprintf(file, "# samples,rms_error,peak_error,lag_s,correlation,moves,mean_settling_s,mean_overshoot,max_overshoot\n");
+	std::fprintf(file, "# %llu,%f,%f,%f,%f,%zu,%f,%f,%f\n", (unsigned long long)Count, Rms(), Peak(), Lag(), correlation, MovesSeen, MeanSettling(), MeanOvershoot(), OvershootMax);
+
+	std::fprintf(file, "start_s,from,to,distance,overshoot,overshoot_pct,settling_s\n");
+
+	for (const Move& move : Finished) {
+
+		const double distance = fabs((double)move.To - move.From);
+
+		std::fprintf(file, "%f,%d,%d,%.0f,%.0f,%f,%f\n", move.Start, move.From, move.To, distance, move.Overshoot, distance > 0 ? move.Overshoot / distance * 100.0 : 0.0, move.Settling);
+	}
+
+	const bool bOk = !std::ferror(file);
+
+	std::fclose(file);
+
+	return bOk;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+// how well a TIC follows its target, worked out as samples arrive. over a sliding window:
+// RMS and peak error, and the lag that best lines position up with target by cross
+// correlation. per move, a target change that then holds: overshoot and settling time
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "sliding_window.h"
+
+class TrackingAnalytics {
+
+public:
+
+	// samples in the sliding window, and the most samples position can lag target by
+	static constexpr size_t Window = 2048;
+	static constexpr size_t MaxLag = 256;
+
+	// a target unchanged this long ends a move
+	static constexpr double HoldTime = 0.05;
+
+	// settled once within this fraction of the move, but never tighter than SettleSteps
+	static constexpr double SettleBand = 0.02;
+	static constexpr int32_t SettleSteps = 2;
+
+	// moves kept for export, the summary covers every move since Reset()
+	static constexpr size_t MaxMoves = 10000;
+
+	struct Move {
+		double Start;
+		int32_t From;
+		int32_t To;
+
+		// steps past To in the direction of travel
+		double Overshoot;
+
+		// seconds from Start until position stayed inside the band, -1 if it hasn't
+		double Settling;
+	};
+
+	TrackingAnalytics();
+
+	void Add(double time, int32_t target, int32_t position);
+	void Reset();
+
+	uint64_t Samples() const { return Count; }
+
+	// target - position over the window, in steps
+	double Rms() const;
+	double Peak() const;
+
+	// seconds position trails target by, and how well they line up there (-1 to 1)
+	double Lag() const;
+	double Correlation() const;
+
+	// finished moves, oldest first
+	const std::deque<Move>& Moves() const { return Finished; }
+
+	size_t MoveCount() const { return MovesSeen; }
+	double MeanSettling() const { return SettledCount ? SettlingSum / SettledCount : 0; }
+	double MeanOvershoot() const { return MovesSeen ? OvershootSum / MovesSeen : 0; }
+	double MaxOvershoot() const { return OvershootMax; }
+
+	// write the summary and every move kept as CSV
+	bool Export(const std::string& path) const;
+
+private:
+
+	// ring holds the window plus the lags reaching back before it
+	static constexpr size_t RingSize = Window + MaxLag + 1;
+
+	size_t At(uint64_t index) const { return (size_t)(index % RingSize); }
+
+	// best lag in samples, fractional, and its correlation
+	void FindLag(double& lag, double& correlation) const;
+
+	// running sums drift as samples come and go, recompute them from the ring
+	void Resync();
+
+	void UpdateMove(double time, int32_t target, int32_t position);
+	void FinishMove();
+
+	std::vector<double> Times;
+	std::vector<double> Targets;
+	std::vector<double> Positions;
+	std::vector<double> Errors;
+
+	uint64_t Count = 0;
+	uint64_t SinceResync = 0;
+
+	// subtracted from both signals to keep the products small
+	double Reference = 0;
+
+	double SumTarget = 0;
+	double SumPosition = 0;
+	double SumTarget2 = 0;
+	double SumPosition2 = 0;
+
+	// sum over the window of target[i - lag] * position[i]
+	std::vector<double> Cross;
+
+	// correlation at each lag, and the last FindLag() result
+	mutable std::vector<double> Scores;
+	mutable uint64_t LagCount = UINT64_MAX;
+	mutable double CachedLag = 0;
+	mutable double CachedCorrelation = 0;
+
+	SlidingStats ErrorStats;
+	SlidingStats SquareStats;
+
+	// move in progress
+	bool bMoving = false;
+	bool bMeasuring = false;
+	int32_t LastTarget = 0;
+	double HeldSince = 0;
+	int Direction = 0;
+	Move Current = {};
+
+	std::deque<Move> Finished;
+
+	size_t MovesSeen = 0;
+	size_t SettledCount = 0;
+	double SettlingSum = 0;
+	double OvershootSum = 0;
+	double OvershootMax = 0;
+};
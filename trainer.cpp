@@ -0,0 +1,240 @@
+#include "trainer.h"
+
+#include <cstdio>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+void Trainer::Start(TicContext& context, std::vector<TrainerPhase> phases)
+{
+	Stop();
+
+	Context = &context;
+	Phases = std::move(phases);
+
+	{
+		std::lock_guard<std::mutex> lock(StatsMutex);
+
+		Stats.assign(Phases.size(), TrainerStats());
+
+		for (size_t i = 0; i < Phases.size(); i++) {
+			Stats[i].Name = Phases[i].Name;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(ErrorMutex);
+		LastError.clear();
+	}
+
+	Phase.store(-1);
+	Remaining.store(0);
+	Dropped.store(0);
+
+	if (Phases.empty()) {
+		return;
+	}
+
+	bRunning.store(true);
+
+	Worker = std::thread(&Trainer::Run, this);
+}
+
+void Trainer::Stop()
+{
+	bRunning.store(false);
+
+	if (Worker.joinable()) {
+		Worker.join();
+	}
+}
+
+std::vector<TrainerStats> Trainer::GetStats()
+{
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	return Stats;
+}
+
+std::string Trainer::GetLastError()
+{
+	std::lock_guard<std::mutex> lock(ErrorMutex);
+	return LastError;
+}
+
+void Trainer::OnSample(const TicSample& sample)
+{
+	if (!Samples.Push(sample)) {
+		Dropped++;
+	}
+}
+
+double Trainer::Enter(const TrainerPhase& phase)
+{
+	Context->Acq.SetTable(phase.Table);
+
+	double start;
+
+	try {
+		auto lock = Context->Acq.LockDevice();
+
+		if (phase.bEnergised) {
+			Context->Device->energize();
+		}
+		else {
+			Context->Device->deenergize();
+		}
+
+		// under the lock, so every sample polled before the switch is stamped earlier
+		start = Context->Acq.GetTime();
+	}
+	catch (const std::exception& error) {
+
+		std::lock_guard<std::mutex> lock(ErrorMutex);
+
+		LastError = error.what();
+		std::cerr << "Error: " << LastError << std::endl;
+
+		start = Context->Acq.GetTime();
+	}
+
+	bEnergised.store(phase.bEnergised);
+
+	return start;
+}
+
+void Trainer::Drain(TrainerStats& stats, double start)
+{
+	TicSample sample;
+
+	while (Samples.Pop(sample)) {
+		if (sample.Time >= start) {
+			stats.Vin.Push(sample.VinVoltage / 1000.0);
+		}
+	}
+}
+
+void Trainer::Publish(size_t index, const TrainerStats& stats)
+{
+	std::lock_guard<std::mutex> lock(StatsMutex);
+	Stats[index] = stats;
+}
+
+bool Trainer::Export(const std::string& path)
+{
+	const std::vector<TrainerStats> stats = GetStats();
+
+	FILE* file = std::fopen(path.c_str(), "w");
+
+	if (!file) {
+		return false;
+	}
+
+	std::fprintf(file, "phase,complete,samples,mean_v,stddev_v,min_v,p1_v,p50_v,p99_v,max_v\n");
+
+	for (const TrainerStats& phase : stats) {
+
+		const RunningStats& vin = phase.Vin.Stats;
+
+		std::fprintf(file, "%s,%d,%llu,%f,%f,%f,%f,%f,%f,%f\n", phase.Name.c_str(), phase.bValid ? 1 : 0, (unsigned long long)vin.Samples(),
+			vin.Avg(), vin.StdDev(), vin.Min(), phase.Vin.P1.Get(), phase.Vin.P50.Get(), phase.Vin.P99.Get(), vin.Max());
+	}
+
+	// only the bins something landed in
+	size_t first = TrainerStats::HistogramBins, last = 0;
+
+	for (const TrainerStats& phase : stats) {
+
+		const std::vector<uint64_t>& bins = phase.Vin.Bins.Bins();
+
+		for (size_t i = 0; i < bins.size(); i++) {
+			if (bins[i]) {
+				first = (i < first) ? i : first;
+				last = (i > last) ? i : last;
+			}
+		}
+	}
+
+	std::fprintf(file, "\nbin_low_v");
+
+	for (const TrainerStats& phase : stats) {
+		std::fprintf(file, ",%s", phase.Name.c_str());
+	}
+
+	std::fprintf(file, "\n");
+
+	for (size_t i = first; i <= last && i < TrainerStats::HistogramBins; i++) {
+
+		std::fprintf(file, "%f", TrainerStats::HistogramLow + i * (TrainerStats::HistogramHigh - TrainerStats::HistogramLow) / TrainerStats::HistogramBins);
+
+		for (const TrainerStats& phase : stats) {
+			std::fprintf(file, ",%llu", (unsigned long long)phase.Vin.Bins.Bins()[i]);
+		}
+
+		std::fprintf(file, "\n");
+	}
+
+	const bool bOk = !std::ferror(file);
+
+	std::fclose(file);
+
+	return bOk;
+}
+
+void Trainer::Run()
+{
+	const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(DrainInterval));
+
+	// whatever the ring still holds from a run before is older than the first phase, Drain() skips it
+	Context->Acq.SetSink(this);
+
+	for (size_t i = 0; i < Phases.size() && bRunning.load(); i++) {
+
+		const TrainerPhase& phase = Phases[i];
+
+		TrainerStats stats;
+
+		stats.Name = phase.Name;
+
+		Phase.store((int)i);
+
+		const double start = Enter(phase);
+
+		// phases last their duration on the device's clock, so a sped up simulator runs them faster
+		const double end = start + phase.Duration;
+
+		while (bRunning.load()) {
+
+			const double now = Context->Acq.GetTime();
+
+			Drain(stats, start);
+
+			if (now >= end) {
+				break;
+			}
+
+			Publish(i, stats);
+
+			Remaining.store(end - now);
+
+			// phases are seconds long, the scheduler tick is close enough
+			std::this_thread::sleep_for(interval);
+		}
+
+		// a cancelled phase keeps what it got but isn't marked complete
+		stats.bValid = bRunning.load();
+
+		Publish(i, stats);
+	}
+
+	Context->Acq.SetSink(nullptr);
+
+	// done or cancelled, the motor is left off and holding nothing
+	TrainerPhase off;
+
+	Enter(off);
+
+	Phase.store(-1);
+	Remaining.store(0);
+
+	bRunning.store(false);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// runs a list of phases on one TIC from its own thread and steady clock, so a phase
+// lasts as long as it says whether or not the Trainer window is drawn or the plots paused.
+// every sample polled during a phase goes into that phase's own summary
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "acquisition.h"
+#include "profile.h"
+#include "spsc_ring.h"
+#include "streaming_stats.h"
+#include "tic_context.h"
+
+struct TrainerPhase {
+	std::string Name;
+
+	// seconds collected for
+	double Duration = 30.0;
+
+	bool bEnergised = false;
+
+	// what the TIC follows during the phase, nullptr holds still
+	std::shared_ptr<const SetpointTable> Table;
+};
+
+// VIN over every sample in a phase in volts, fixed memory however long the phase or fast the poll
+struct TrainerStats {
+
+	// histogram edges, the same for every phase and run so they compare bin for bin
+	static constexpr double HistogramLow = 0;
+	static constexpr double HistogramHigh = 60;
+	static constexpr size_t HistogramBins = 1200;
+
+	std::string Name;
+
+	StreamSummary Vin{ HistogramLow, HistogramHigh, HistogramBins };
+
+	// set once the phase has run to the end, until then it's the phase so far
+	bool bValid = false;
+};
+
+class Trainer : public SampleSink {
+
+public:
+
+	// samples the thread can fall behind the acquisition thread by
+	static constexpr size_t RingSize = 8192;
+
+	// how often the thread wakes to drain samples and check the clock
+	static constexpr double DrainInterval = 0.01;
+
+	Trainer() {}
+	~Trainer() { Stop(); }
+
+	Trainer(const Trainer&) = delete;
+	Trainer& operator=(const Trainer&) = delete;
+
+	// run phases in order on context, a run already going is cancelled first
+	void Start(TicContext& context, std::vector<TrainerPhase> phases);
+
+	// cancel, the motor is left de-energised and still
+	void Stop();
+
+	bool IsRunning() const { return bRunning.load(); }
+	bool IsTraining(const TicContext& context) const { return bRunning.load() && Context == &context; }
+
+	// what the running phase asked for, for the GUI to mirror
+	bool IsEnergised() const { return bEnergised.load(); }
+
+	// phase running, -1 before the first and once done, and seconds left in it
+	int GetPhase() const { return Phase.load(); }
+	double GetRemaining() const { return Remaining.load(); }
+
+	// one per phase of the last run, finished phases marked valid
+	std::vector<TrainerStats> GetStats();
+
+	// summary of every phase and their histograms side by side as CSV
+	bool Export(const std::string& path);
+
+	// samples lost because the thread fell behind
+	uint64_t GetDropped() const { return Dropped.load(); }
+
+	// last error from the device, empty if none
+	std::string GetLastError();
+
+	// acquisition thread
+	void OnSample(const TicSample& sample) override;
+
+private:
+
+	void Run();
+
+	// energise or not and start the phase's table, on the trainer thread. returns the
+	// device time the TIC was switched at, samples before it belong to the phase before
+	double Enter(const TrainerPhase& phase);
+
+	// samples queued so far from start on go to the phase's summary
+	void Drain(TrainerStats& stats, double start);
+
+	// copy for GetStats(), the GUI sees a phase fill in as it runs
+	void Publish(size_t index, const TrainerStats& stats);
+
+	TicContext* Context = nullptr;
+	std::vector<TrainerPhase> Phases;
+
+	std::thread Worker;
+	std::mutex StatsMutex;
+	std::mutex ErrorMutex;
+
+	std::atomic<bool> bRunning{ false };
+	std::atomic<bool> bEnergised{ false };
+	std::atomic<int> Phase{ -1 };
+	std::atomic<double> Remaining{ 0 };
+	std::atomic<uint64_t> Dropped{ 0 };
+
+	std::vector<TrainerStats> Stats;
+
+	std::string LastError;
+
+	SpscRing<TicSample, RingSize> Samples;
+};
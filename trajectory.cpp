@@ -0,0 +1,191 @@
+#include "trajectory.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "precise_sleep.h"
+
+void TrajectoryScheduler::Start(std::vector<Axis> axes, double rateHz)
+{
+	Stop();
+
+	Axes = std::move(axes);
+	RateHz = std::min(rateHz > 0 ? rateHz : 1.0, MaxRateHz);
+
+	Length = 0;
+
+	for (const Axis& axis : Axes) {
+		if (axis.Setpoints.size() > Length) {
+			Length = axis.Setpoints.size();
+		}
+	}
+
+	Tick.store(0);
+	Late.store(0);
+
+	{
+		std::lock_guard<std::mutex> lock(SkewMutex);
+
+		SkewLast = 0;
+		SkewMax = 0;
+		SkewSum = 0;
+		SkewTicks = 0;
+	}
+
+	if (Axes.empty() || Length == 0) {
+		return;
+	}
+
+	// everything the threads need is allocated up front
+	SentAt.assign(Axes.size() * Length, Clock::time_point());
+	SentCount.reset(new std::atomic<size_t>[Length]);
+
+	for (size_t tick = 0; tick < Length; tick++) {
+		SentCount[tick].store(0);
+	}
+
+	// the first tick leaves every thread time to start and take its lock
+	FirstTick = Clock::now() + std::chrono::milliseconds(10);
+
+	bRunning.store(true);
+	Running.store(Axes.size());
+
+	for (size_t i = 0; i < Axes.size(); i++) {
+		Workers.emplace_back(&TrajectoryScheduler::Run, this, i);
+	}
+}
+
+void TrajectoryScheduler::Stop()
+{
+	bRunning.store(false);
+
+	for (std::thread& worker : Workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+
+	Workers.clear();
+}
+
+double TrajectoryScheduler::GetProgress() const
+{
+	return Length ? (double)Tick.load() / Length : 0;
+}
+
+TrajectoryScheduler::Skew TrajectoryScheduler::GetSkew() const
+{
+	Skew skew;
+
+	{
+		std::lock_guard<std::mutex> lock(SkewMutex);
+
+		skew.Last = SkewLast;
+		skew.Max = SkewMax;
+		skew.Mean = SkewTicks ? SkewSum / SkewTicks : 0;
+	}
+
+	skew.Ticks = Tick.load();
+	skew.Late = Late.load();
+
+	return skew;
+}
+
+std::string TrajectoryScheduler::GetLastError()
+{
+	std::lock_guard<std::mutex> lock(ErrorMutex);
+	return LastError;
+}
+
+void TrajectoryScheduler::Sent(size_t tick)
+{
+	// the others' times were stored before their increments
+	if (SentCount[tick].fetch_add(1) + 1 < Axes.size()) {
+		return;
+	}
+
+	Clock::time_point first = SentAt[tick];
+	Clock::time_point last = SentAt[tick];
+
+	for (size_t i = 1; i < Axes.size(); i++) {
+		first = std::min(first, SentAt[i * Length + tick]);
+		last = std::max(last, SentAt[i * Length + tick]);
+	}
+
+	const double skew = std::chrono::duration<double>(last - first).count();
+
+	std::lock_guard<std::mutex> lock(SkewMutex);
+
+	SkewLast = skew;
+	SkewSum += skew;
+	SkewTicks++;
+
+	if (skew > SkewMax) {
+		SkewMax = skew;
+	}
+
+	if (tick + 1 > Tick.load()) {
+		Tick.store(tick + 1);
+	}
+}
+
+void TrajectoryScheduler::Run(size_t index)
+{
+	Axis& axis = Axes[index];
+
+	const auto period = std::chrono::duration<double>(1.0 / RateHz);
+	const auto lead = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::min(LockLead, period.count() / 4)));
+
+	for (size_t tick = 0; tick < Length && bRunning.load(); tick++) {
+
+		const Clock::time_point deadline = FirstTick + std::chrono::duration_cast<Clock::duration>(period * (double)tick);
+
+		// axes with shorter streams hold their last setpoint
+		const int32_t setpoint = axis.Setpoints.empty() ? 0 : axis.Setpoints[tick < axis.Setpoints.size() ? tick : axis.Setpoints.size() - 1];
+
+		SleepUntil(deadline - lead);
+
+		std::unique_lock<std::mutex> lock;
+
+		if (axis.Acq) {
+			lock = axis.Acq->LockDevice();
+		}
+
+		if (Clock::now() > deadline) {
+			Late++;
+		}
+
+		SleepUntil(deadline);
+
+		// kept pointing at the same setpoint so its poll doesn't send an older target
+		if (axis.Acq) {
+			axis.Acq->SetTarget(setpoint);
+		}
+
+		SentAt[index * Length + tick] = Clock::now();
+
+		try {
+			axis.Device->set_target_position(setpoint);
+		}
+		catch (const std::exception& error) {
+
+			std::lock_guard<std::mutex> errorLock(ErrorMutex);
+
+			if (LastError != error.what()) {
+				LastError = error.what();
+				std::cerr << "Error: " << LastError << std::endl;
+			}
+		}
+
+		if (lock) {
+			lock.unlock();
+		}
+
+		Sent(tick);
+	}
+
+	// the last axis to finish ends the move
+	if (Running.fetch_sub(1) == 1) {
+		bRunning.store(false);
+	}
+}
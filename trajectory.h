@@ -0,0 +1,127 @@
+#pragma once
+
+// coordinated moves across several TICs. every axis gets its setpoints worked out
+// before the move starts, then each axis has its own thread sending tick k at the shared
+// deadline start + k / rate. the USB transfers go out in parallel rather than back to back,
+// so the spread between axes is thread wake jitter rather than a round-trip per axis, and
+// the axes stay together whatever the GUI frame rate is
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "acquisition.h"
+#include "tic_device.h"
+
+class TrajectoryScheduler {
+
+public:
+
+	// how long before each tick an axis takes its device lock, so an acquisition poll in
+	// flight doesn't hold up the send. never more than a quarter of the period, so the
+	// acquisition thread still gets the device between ticks
+	static constexpr double LockLead = 0.002;
+
+	// fastest tick rate, a 4ms period leaves the acquisition polls most of each tick
+	static constexpr double MaxRateHz = 250.0;
+
+	struct Axis {
+		TicDevice* Device = nullptr;
+
+		// kept pointing at the same setpoint so its poll doesn't send an older target
+		Acquisition* Acq = nullptr;
+
+		// one per tick
+		std::vector<int32_t> Setpoints;
+	};
+
+	// time between the first and last axis starting to send the same tick, in seconds
+	struct Skew {
+		double Last = 0;
+		double Max = 0;
+		double Mean = 0;
+
+		// ticks sent
+		uint64_t Ticks = 0;
+
+		// ticks that went out after their deadline, the locks took too long
+		uint64_t Late = 0;
+	};
+
+	TrajectoryScheduler() {}
+	~TrajectoryScheduler() { Stop(); }
+
+	TrajectoryScheduler(const TrajectoryScheduler&) = delete;
+	TrajectoryScheduler& operator=(const TrajectoryScheduler&) = delete;
+
+	// run every axis through its setpoints at rateHz (up to MaxRateHz), ends after the longest one
+	void Start(std::vector<Axis> axes, double rateHz);
+	void Stop();
+
+	bool IsRunning() const { return bRunning.load(); }
+
+	// acq is one of the running move's axes, GUI thread
+	bool IsDriving(const Acquisition* acq) const
+	{
+		if (!bRunning.load()) {
+			return false;
+		}
+
+		for (const Axis& axis : Axes) {
+			if (axis.Acq == acq) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// 0 to 1 through the move
+	double GetProgress() const;
+
+	Skew GetSkew() const;
+
+	// last error from any axis, empty if none
+	std::string GetLastError();
+
+private:
+
+	using Clock = std::chrono::steady_clock;
+
+	// one axis's thread
+	void Run(size_t index);
+
+	// the last axis to send tick works out its skew
+	void Sent(size_t tick);
+
+	std::vector<Axis> Axes;
+	double RateHz = 100.0;
+	size_t Length = 0;
+	Clock::time_point FirstTick;
+
+	std::vector<std::thread> Workers;
+	std::mutex ErrorMutex;
+	mutable std::mutex SkewMutex;
+
+	std::atomic<bool> bRunning{ false };
+	std::atomic<size_t> Running{ 0 };
+	std::atomic<size_t> Tick{ 0 };
+
+	// when each axis started sending each tick, [axis * Length + tick], and how many axes
+	// have sent each tick
+	std::vector<Clock::time_point> SentAt;
+	std::unique_ptr<std::atomic<size_t>[]> SentCount;
+
+	double SkewLast = 0;
+	double SkewMax = 0;
+	double SkewSum = 0;
+	uint64_t SkewTicks = 0;
+	std::atomic<uint64_t> Late{ 0 };
+
+	std::string LastError;
+};
@@ -0,0 +1,665 @@
+#include "tuner.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+using Clock = std::chrono::steady_clock;
+
+// errors that mean the motor couldn't keep up
+static constexpr uint32_t ErrorMask = (1 << TIC_ERROR_MOTOR_DRIVER_ERROR) | (1 << TIC_ERROR_LOW_VIN) | (1 << TIC_ERROR_ERR_LINE_HIGH) | (1 << TIC_ERROR_ENCODER_SKIP);
+
+// seconds of holding still to measure VIN with nothing moving
+static constexpr double BaselineTime = 1.0;
+
+static uint32_t ToSpeed(const TunerCandidate& candidate)
+{
+	const double speed = candidate.Speed * Microsteps(candidate.StepMode) * 10000.0;
+
+	return (uint32_t)(speed > TIC_MAX_ALLOWED_SPEED ? TIC_MAX_ALLOWED_SPEED : speed);
+}
+
+static uint32_t ToAccel(const TunerCandidate& candidate)
+{
+	const double accel = candidate.Accel * Microsteps(candidate.StepMode) * 100.0;
+
+	return (uint32_t)(accel > TIC_MAX_ALLOWED_ACCEL ? TIC_MAX_ALLOWED_ACCEL : (accel < TIC_MIN_ALLOWED_ACCEL ? TIC_MIN_ALLOWED_ACCEL : accel));
+}
+
+void SweepTuner::Start(TicContext& context, const Config& config)
+{
+	Stop();
+
+	Settings = config;
+
+	{
+		std::lock_guard<std::mutex> lock(ResultsMutex);
+
+		Done.clear();
+		BestIndex = SIZE_MAX;
+		bFinished = false;
+		Error.clear();
+		State = Phase::Baseline;
+	}
+
+	GridIndex = 0;
+	Coordinate = 0;
+	ValueIndex = 0;
+	Pass = 0;
+	bImproved = false;
+
+	const tic_settings* s = context.Settings.get_pointer();
+
+	Original.StepMode = tic_settings_get_step_mode(s);
+	Original.Speed = tic_settings_get_max_speed(s) / (Microsteps(Original.StepMode) * 10000.0);
+	Original.Accel = tic_settings_get_max_accel(s) / (Microsteps(Original.StepMode) * 100.0);
+	Original.CurrentLimit = tic_settings_get_current_limit(s);
+
+	Candidate = Original;
+
+	Centre = context.Sample.CurrentPosition;
+
+	Context = &context;
+
+	try {
+		auto lock = context.Acq.LockDevice();
+		context.Device->energize();
+		context.bEnabled = true;
+	}
+	catch (const std::exception& error) {
+		std::lock_guard<std::mutex> lock(ResultsMutex);
+		Error = error.what();
+		Context = nullptr;
+		return;
+	}
+
+	// hold still for the baseline
+	context.Profile = -1;
+	Hold();
+
+	PhaseStart = -1;
+	BaselineSum = 0;
+	BaselineCount = 0;
+
+	bRunning.store(true);
+
+	Worker = std::thread(&SweepTuner::Run, this);
+}
+
+SweepTuner::~SweepTuner()
+{
+	bRunning.store(false);
+
+	if (Worker.joinable()) {
+		Worker.join();
+	}
+}
+
+void SweepTuner::Stop()
+{
+	if (!Context) {
+		return;
+	}
+
+	Release();
+}
+
+void SweepTuner::Collect(TicContext& context)
+{
+	if (Context != &context || bRunning.load()) {
+		return;
+	}
+
+	Release();
+}
+
+void SweepTuner::Release()
+{
+	bRunning.store(false);
+
+	if (Worker.joinable()) {
+		Worker.join();
+	}
+
+	TicContext& context = *Context;
+
+	if (bFinished) {
+
+		// the sliders and settings follow, Update writes them to the TIC for good
+		tic_settings* s = context.Settings.get_pointer();
+
+		tic_settings_set_step_mode(s, Chosen.StepMode);
+		tic_settings_set_current_limit(s, Chosen.CurrentLimit);
+		tic_settings_set_max_speed(s, ToSpeed(Chosen));
+		tic_settings_set_max_accel(s, ToAccel(Chosen));
+		tic_settings_set_max_decel(s, ToAccel(Chosen));
+
+		context.step_mode = Chosen.StepMode;
+		context.current_limit = tic_settings_get_current_limit(s);
+		context.iMaxSpeed = ToSpeed(Chosen);
+		context.iMaxAcceleration = ToAccel(Chosen);
+		context.iMaxDeceleration = ToAccel(Chosen);
+		context.bChanged = true;
+	}
+	else {
+		try {
+			Apply(Original);
+		}
+		catch (const std::exception& error) {
+			std::lock_guard<std::mutex> lock(ResultsMutex);
+			Error = error.what();
+		}
+	}
+
+	context.Acq.SetTable(nullptr);
+	context.Target = Centre;
+
+	Context = nullptr;
+}
+
+void SweepTuner::OnSample(const TicSample& sample)
+{
+	// nothing counts dropped samples, a candidate just measures over fewer
+	Samples.Push(sample);
+}
+
+void SweepTuner::Run()
+{
+	const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(DrainInterval));
+
+	// whatever the ring held from a run before belongs to nobody
+	Context->Acq.SetSink(this);
+
+	{
+		TicSample stale;
+
+		while (Samples.Pop(stale)) {
+		}
+	}
+
+	Clock::time_point next = Clock::now();
+
+	while (bRunning.load()) {
+
+		TicSample sample;
+
+		while (bRunning.load() && Samples.Pop(sample)) {
+			Observe(sample);
+		}
+
+		next += interval;
+		std::this_thread::sleep_until(next);
+	}
+
+	Context->Acq.SetSink(nullptr);
+}
+
+void SweepTuner::Hold()
+{
+	SetpointTable hold;
+
+	hold.Setpoints.push_back(Centre);
+
+	Context->Acq.SetTable(std::make_shared<const SetpointTable>(std::move(hold)));
+}
+
+void SweepTuner::Apply(const TunerCandidate& candidate)
+{
+	auto lock = Context->Acq.LockDevice();
+
+	Context->Device->set_step_mode(candidate.StepMode);
+	Context->Device->set_current_limit(candidate.CurrentLimit);
+	Context->Device->set_max_speed(ToSpeed(candidate));
+	Context->Device->set_max_accel(ToAccel(candidate));
+	Context->Device->set_max_decel(ToAccel(candidate));
+}
+
+void SweepTuner::RunMoves(const TunerCandidate& candidate)
+{
+	SetpointTable table;
+
+	const int32_t half = (int32_t)(Settings.Distance * Microsteps(candidate.StepMode) / 2.0);
+	const size_t dwell = (size_t)(Settings.Dwell * table.RateHz);
+
+	table.Setpoints.resize(dwell * 2);
+
+	for (size_t i = 0; i < table.Setpoints.size(); i++) {
+		table.Setpoints[i] = (i < dwell) ? Centre + half : Centre - half;
+	}
+
+	Context->Acq.SetTable(std::make_shared<const SetpointTable>(std::move(table)));
+}
+
+void SweepTuner::Observe(const TicSample& sample)
+{
+	const double t = sample.Time;
+
+	if (PhaseStart < 0) {
+		PhaseStart = t;
+	}
+
+	const double period = 2.0 * Settings.Dwell;
+
+	bool bNext = false;
+
+	switch (State) {
+
+	case Phase::Baseline:
+
+		BaselineSum += sample.VinVoltage / 1000.0;
+		BaselineCount++;
+
+		if (t - PhaseStart >= BaselineTime) {
+			std::lock_guard<std::mutex> lock(ResultsMutex);
+			Baseline = BaselineSum / BaselineCount;
+			bNext = true;
+		}
+
+		break;
+
+	case Phase::Warmup:
+
+		// measuring starts mid dwell so every move in the window gets a full dwell but the last
+		if (t - PhaseStart >= Settings.WarmupPeriods * period + Settings.Dwell / 2.0) {
+
+			{
+				std::lock_guard<std::mutex> lock(ResultsMutex);
+				State = Phase::Measure;
+			}
+
+			PhaseStart = t;
+
+			Tracking.Reset();
+			VinLow = DBL_MAX;
+			OccurredBefore = sample.ErrorsOccurred;
+			Errors = 0;
+		}
+
+		break;
+
+	case Phase::Measure:
+
+		Tracking.Add(t, sample.RequestPosition, sample.CurrentPosition);
+
+		if (sample.VinVoltage / 1000.0 < VinLow) {
+			VinLow = sample.VinVoltage / 1000.0;
+		}
+
+		Errors |= (sample.ErrorStatus | (sample.ErrorsOccurred & ~OccurredBefore)) & ErrorMask;
+
+		if (t - PhaseStart >= Settings.MeasurePeriods * period) {
+
+			const TunerResult result = Score();
+
+			std::lock_guard<std::mutex> lock(ResultsMutex);
+
+			Done.push_back(result);
+
+			if (result.bStable && (!Best() || result.Settling < Best()->Settling)) {
+				BestIndex = Done.size() - 1;
+			}
+
+			bNext = true;
+		}
+
+		break;
+	}
+
+	if (!bNext) {
+		return;
+	}
+
+	bool bMore;
+
+	{
+		std::lock_guard<std::mutex> lock(ResultsMutex);
+		bMore = Next();
+	}
+
+	if (!bMore) {
+		Finish();
+		return;
+	}
+
+	try {
+		Apply(Candidate);
+		RunMoves(Candidate);
+	}
+	catch (const std::exception& error) {
+
+		// Release() puts the TIC's own settings back
+		{
+			std::lock_guard<std::mutex> lock(ResultsMutex);
+			Error = error.what();
+		}
+
+		Hold();
+		bRunning.store(false);
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(ResultsMutex);
+		State = Phase::Warmup;
+	}
+
+	PhaseStart = t;
+}
+
+TunerResult SweepTuner::Score() const
+{
+	TunerResult result = {};
+
+	const double scale = Microsteps(Candidate.StepMode);
+
+	result.Candidate = Candidate;
+	result.Rms = Tracking.Rms() / scale;
+	result.Peak = Tracking.Peak() / scale;
+	result.Sag = (VinLow < DBL_MAX) ? Baseline - VinLow : 0;
+	result.Errors = Errors;
+
+	bool bSettled = !Tracking.Moves().empty();
+
+	double settling = 0;
+
+	for (const TrackingAnalytics::Move& move : Tracking.Moves()) {
+
+		if (move.Settling < 0) {
+			bSettled = false;
+			settling += Settings.Dwell;
+		}
+		else {
+			settling += move.Settling;
+		}
+
+		if (move.Overshoot / scale > result.Overshoot) {
+			result.Overshoot = move.Overshoot / scale;
+		}
+	}
+
+	result.Settling = Tracking.Moves().empty() ? Settings.Dwell : settling / Tracking.Moves().size();
+
+	result.bStable = bSettled && Errors == 0 && result.Sag <= Settings.MaxSag && result.Overshoot <= Settings.MaxOvershoot * Settings.Distance;
+
+	return result;
+}
+
+std::vector<double> SweepTuner::Values(int p) const
+{
+	std::vector<double> values;
+
+	const int points = Settings.Points > 1 ? Settings.Points : 1;
+
+	auto spread = [&](double low, double high, bool bRatio) {
+
+		for (int i = 0; i < points; i++) {
+
+			const double f = (points > 1) ? (double)i / (points - 1) : 0;
+
+			values.push_back(bRatio ? low * pow(high / low, f) : low + (high - low) * f);
+		}
+	};
+
+	switch (p) {
+	case 0:
+		spread(Settings.SpeedMin, Settings.SpeedMax, true);
+		break;
+	case 1:
+		spread(Settings.AccelMin, Settings.AccelMax, true);
+		break;
+	case 2:
+		spread(Settings.CurrentMin, Settings.CurrentMax, false);
+		break;
+	default:
+		for (int mode = Settings.StepModeMin; mode <= Settings.StepModeMax; mode++) {
+			values.push_back(mode);
+		}
+		break;
+	}
+
+	return values;
+}
+
+double SweepTuner::Get(const TunerCandidate& candidate, int p)
+{
+	switch (p) {
+	case 0:
+		return candidate.Speed;
+	case 1:
+		return candidate.Accel;
+	case 2:
+		return candidate.CurrentLimit;
+	default:
+		return candidate.StepMode;
+	}
+}
+
+TunerCandidate SweepTuner::With(const TunerCandidate& candidate, int p, double value)
+{
+	TunerCandidate with = candidate;
+
+	switch (p) {
+	case 0:
+		with.Speed = value;
+		break;
+	case 1:
+		with.Accel = value;
+		break;
+	case 2:
+		with.CurrentLimit = (uint32_t)value;
+		break;
+	default:
+		with.StepMode = (uint8_t)value;
+		break;
+	}
+
+	return with;
+}
+
+size_t SweepTuner::Planned() const
+{
+	// the grid is every combination, coordinate search the baseline then each value once
+	size_t planned = 1;
+
+	for (int p = 0; p < 4; p++) {
+		if (Settings.Mode == Search::Grid) {
+			planned *= Values(p).size();
+		}
+		else {
+			planned += Values(p).size();
+		}
+	}
+
+	return planned;
+}
+
+bool SweepTuner::Next()
+{
+	if (Settings.Mode == Search::Grid) {
+
+		if (GridIndex >= Planned()) {
+			return false;
+		}
+
+		size_t index = GridIndex++;
+
+		TunerCandidate candidate = Original;
+
+		for (int p = 0; p < 4; p++) {
+
+			const std::vector<double> values = Values(p);
+
+			candidate = With(candidate, p, values[index % values.size()]);
+			index /= values.size();
+		}
+
+		Candidate = candidate;
+
+		return true;
+	}
+
+	// first the TIC's own settings, the rest have to beat them
+	if (Done.empty()) {
+		Incumbent = Original;
+		Candidate = Original;
+		return true;
+	}
+
+	const TunerResult& last = Done.back();
+
+	if (Done.size() == 1) {
+		IncumbentScore = last.bStable ? last.Settling : DBL_MAX;
+	}
+	else if (last.bStable && last.Settling < IncumbentScore * (1.0 - Settings.MinImprovement)) {
+		Incumbent = last.Candidate;
+		IncumbentScore = last.Settling;
+		bImproved = true;
+	}
+	else if (!last.bStable && Coordinate < 2 && Get(last.Candidate, Coordinate) > Get(Incumbent, Coordinate)) {
+		// faster or harder than this only gets worse
+		ValueIndex = Values(Coordinate).size();
+	}
+
+	while (true) {
+
+		const std::vector<double> values = Values(Coordinate);
+
+		while (ValueIndex < values.size()) {
+
+			const double value = values[ValueIndex++];
+
+			if (value == Get(Incumbent, Coordinate)) {
+				continue;
+			}
+
+			Candidate = With(Incumbent, Coordinate, value);
+
+			return true;
+		}
+
+		Coordinate++;
+		ValueIndex = 0;
+
+		if (Coordinate < 4) {
+			continue;
+		}
+
+		// another pass if anything moved, parameters interact
+		Pass++;
+
+		if (!bImproved || Pass >= 2) {
+			return false;
+		}
+
+		Coordinate = 0;
+		bImproved = false;
+	}
+}
+
+void SweepTuner::Finish()
+{
+	const TunerCandidate chosen = Best() ? Best()->Candidate : Original;
+
+	std::string error;
+
+	try {
+		Apply(chosen);
+	}
+	catch (const std::exception& exception) {
+		error = exception.what();
+	}
+
+	// still until Collect() hands the TIC back
+	Hold();
+
+	{
+		std::lock_guard<std::mutex> lock(ResultsMutex);
+
+		Chosen = chosen;
+		bFinished = true;
+
+		if (!error.empty()) {
+			Error = error;
+		}
+	}
+
+	bRunning.store(false);
+}
+
+std::vector<TunerResult> SweepTuner::GetResults()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+	return Done;
+}
+
+TunerCandidate SweepTuner::GetCurrent()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+	return Candidate;
+}
+
+std::string SweepTuner::GetError()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+	return Error;
+}
+
+size_t SweepTuner::GetBest()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+	return BestIndex;
+}
+
+size_t SweepTuner::Tested()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+	return Done.size();
+}
+
+const char* SweepTuner::Status()
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+
+	if (!Context) {
+		return bFinished ? "Done" : (Error.empty() ? "Idle" : "Stopped");
+	}
+
+	switch (State) {
+	case Phase::Baseline:
+		return "Measuring baseline VIN";
+	case Phase::Warmup:
+		return "Warming up";
+	default:
+		return "Measuring";
+	}
+}
+
+bool SweepTuner::Export(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(ResultsMutex);
+
+	FILE* file = std::fopen(path.c_str(), "w");
+
+	if (!file) {
+		return false;
+	}
+
+	std::fprintf(file, "# distance_steps,dwell_s,baseline_vin\n");
+	std::fprintf(file, "# %f,%f,%f\n", Settings.Distance, Settings.Dwell, Baseline);
+	std::fprintf(file, "speed_steps_s,accel_steps_s2,current_ma,step_mode,settling_s,overshoot_steps,rms_steps,peak_steps,sag_v,errors,stable,best\n");
+
+	for (size_t i = 0; i < Done.size(); i++) {
+
+		const TunerResult& result = Done[i];
+
+		std::fprintf(file, "%f,%f,%u,%u,%f,%f,%f,%f,%f,0x%x,%d,%d\n", result.Candidate.Speed, result.Candidate.Accel, result.Candidate.CurrentLimit, result.Candidate.StepMode,
+			result.Settling, result.Overshoot, result.Rms, result.Peak, result.Sag, result.Errors, result.bStable ? 1 : 0, i == BestIndex ? 1 : 0);
+	}
+
+	const bool bOk = !std::ferror(file);
+
+	std::fclose(file);
+
+	return bOk;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+// automatic search for the fastest settings a TIC stays stable at. each candidate
+// max speed / accel / current limit / step mode is sent as volatile runtime commands in
+// one burst, no set_settings + reinitialize, then the TIC's own planner runs a square
+// wave of standard moves while the samples are scored. the search runs on its own thread
+// from a SampleSink, so it keeps time whether or not the GUI is drawing
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "acquisition.h"
+#include "profile.h"
+#include "spsc_ring.h"
+#include "tic_context.h"
+#include "tracking.h"
+
+struct TunerCandidate {
+
+	// full steps per second and per second squared, so step modes compare like for like
+	double Speed;
+	double Accel;
+
+	// milli amps
+	uint32_t CurrentLimit;
+
+	uint8_t StepMode;
+};
+
+struct TunerResult {
+
+	TunerCandidate Candidate;
+
+	// mean seconds for a standard move to settle, lower is faster
+	double Settling;
+
+	double Overshoot;
+	double Rms;
+	double Peak;
+
+	// volts VIN fell below the baseline while moving
+	double Sag;
+
+	// driver, low VIN and ERR line errors raised while moving, the nearest the TIC gets to
+	// reporting missed steps without an encoder
+	uint32_t Errors;
+
+	bool bStable;
+};
+
+class SweepTuner : public SampleSink {
+
+public:
+
+	// samples the thread can fall behind the acquisition thread by
+	static constexpr size_t RingSize = 8192;
+
+	// how often the thread wakes to drain samples
+	static constexpr double DrainInterval = 0.01;
+
+	enum class Search {
+		// every combination of Points values per parameter
+		Grid,
+
+		// one parameter at a time from the TIC's current settings, keeping each improvement
+		Coordinate,
+	};
+
+	struct Config {
+		Search Mode = Search::Coordinate;
+
+		// standard move, full steps each way and the time it's given to finish
+		double Distance = 200;
+		double Dwell = 1.5;
+
+		// square waves run before measuring starts, then measured
+		int WarmupPeriods = 1;
+		int MeasurePeriods = 2;
+
+		// stability limits, overshoot as a fraction of Distance
+		double MaxSag = 0.5;
+		double MaxOvershoot = 0.05;
+
+		// ranges swept, Points values spread over each
+		double SpeedMin = 100, SpeedMax = 2000;
+		double AccelMin = 200, AccelMax = 20000;
+		uint32_t CurrentMin = 200, CurrentMax = 1500;
+		int StepModeMin = 0, StepModeMax = 3;
+		int Points = 5;
+
+		// coordinate search only switches for a score this much better
+		double MinImprovement = 0.02;
+	};
+
+	SweepTuner() {}
+	~SweepTuner();
+
+	SweepTuner(const SweepTuner&) = delete;
+	SweepTuner& operator=(const SweepTuner&) = delete;
+
+	// baseline VIN, then candidates on context until the search is done or Stop()
+	void Start(TicContext& context, const Config& config);
+
+	// keeps the best result if the search got to the end, otherwise puts back the
+	// settings the TIC had before Start()
+	void Stop();
+
+	// GUI thread, every frame for every context. once the search is over the sliders take
+	// the best result and the context is let go
+	void Collect(TicContext& context);
+
+	// true from Start() until the context is let go
+	bool IsRunning() const { return Context != nullptr; }
+	bool IsTuning(const TicContext& context) const { return Context == &context; }
+
+	// copies, the search thread adds to them
+	std::vector<TunerResult> GetResults();
+	TunerCandidate GetCurrent();
+	std::string GetError();
+
+	// index in GetResults() of the fastest stable result, SIZE_MAX if none
+	size_t GetBest();
+
+	// candidates run and the total expected, the total is a guess for coordinate search
+	size_t Tested();
+	size_t Planned() const;
+
+	// what it's doing, for the GUI
+	const char* Status();
+
+	bool Export(const std::string& path);
+
+	// acquisition thread
+	void OnSample(const TicSample& sample) override;
+
+private:
+
+	void Run();
+
+	// one sample polled from the context being tuned, drives the whole search
+	void Observe(const TicSample& sample);
+
+	enum class Phase {
+		Baseline,
+		Warmup,
+		Measure,
+	};
+
+	// volatile commands for candidate, all under one device lock
+	void Apply(const TunerCandidate& candidate);
+
+	// square wave of standard moves about Centre at candidate's step mode
+	void RunMoves(const TunerCandidate& candidate);
+
+	TunerResult Score() const;
+
+	// fastest stable result so far, nullptr if none
+	const TunerResult* Best() const { return BestIndex < Done.size() ? &Done[BestIndex] : nullptr; }
+
+	// the TIC holds Centre while there's nothing else to do
+	void Hold();
+
+	// pick the next candidate from the results so far, false when the search is over
+	bool Next();
+
+	// on the search thread, the best result goes to the TIC
+	void Finish();
+
+	// on the GUI thread once the search thread is done, the sliders and target follow
+	void Release();
+
+	// values tried for parameter p: 0 speed, 1 accel (spaced by ratio), 2 current, 3 step mode
+	std::vector<double> Values(int p) const;
+
+	static double Get(const TunerCandidate& candidate, int p);
+	static TunerCandidate With(const TunerCandidate& candidate, int p, double value);
+
+	// set and cleared on the GUI thread, only while the search thread isn't running
+	TicContext* Context = nullptr;
+	Config Settings;
+
+	std::thread Worker;
+	std::atomic<bool> bRunning{ false };
+
+	// the search thread writes State, Baseline, Candidate, Done, BestIndex, bFinished and
+	// Error under this, the GUI reads them under it
+	std::mutex ResultsMutex;
+
+	// what the TIC had before, put back by Stop()
+	TunerCandidate Original = {};
+
+	Phase State = Phase::Baseline;
+	double PhaseStart = -1;
+
+	int32_t Centre = 0;
+
+	double BaselineSum = 0;
+	uint64_t BaselineCount = 0;
+	double Baseline = 0;
+
+	// while measuring
+	TunerCandidate Candidate = {};
+	TrackingAnalytics Tracking;
+	double VinLow = 0;
+	uint32_t OccurredBefore = 0;
+	uint32_t Errors = 0;
+
+	std::vector<TunerResult> Done;
+	size_t BestIndex = SIZE_MAX;
+
+	// grid position, or coordinate parameter and value index
+	size_t GridIndex = 0;
+	int Coordinate = 0;
+	size_t ValueIndex = 0;
+	int Pass = 0;
+	bool bImproved = false;
+	TunerCandidate Incumbent = {};
+	double IncumbentScore = 0;
+	bool bFinished = false;
+
+	// what Finish() applied
+	TunerCandidate Chosen = {};
+
+	std::string Error;
+
+	SpscRing<TicSample, RingSize> Samples;
+};